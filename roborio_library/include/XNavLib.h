@@ -50,6 +50,8 @@
 
 namespace xnav {
 
+class SimTransport;
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Data structures
 // ─────────────────────────────────────────────────────────────────────────────
@@ -66,6 +68,7 @@ struct TagResult {
     double yaw      = 0.0;   ///< Tag yaw relative to camera (degrees)
     double pitch    = 0.0;   ///< Tag pitch relative to camera (degrees)
     double roll     = 0.0;   ///< Tag roll relative to camera (degrees)
+    double ambiguity = 0.0;  ///< PnP ambiguity ratio (0 = unique, ~1 = two equally good poses)
 };
 
 /** Robot field-centric pose estimated from AprilTags. */
@@ -93,11 +96,16 @@ struct OffsetPoint {
 
 /** XNav system status. */
 struct SystemStatus {
-    std::string status;           ///< "running", "starting", "error"
+    std::string status;           ///< "running", "idle" (low-power), "starting", "error"
     double      fps        = 0.0;
     double      latency_ms = 0.0;
     int         num_targets = 0;
     bool        nt_connected = false;
+    double      temperature_c      = 0.0;
+    double      time_to_throttle_s = -1.0;  ///< Predicted time to CPU clock capping (-1 = not heating)
+    bool        thermal_throttled  = false; ///< CPU clock is being capped right now
+    int         quality_level      = 0;     ///< Latency-SLO operating point (0 = best quality)
+    double      quad_decimate      = 0.0;   ///< Detector decimation in use (0 = controller off)
 };
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -185,6 +193,34 @@ public:
      */
     void SetTurretEnabled(bool enabled);
 
+    // ── Odometry ──────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Send the robot's odometry heading to XNav.
+     * Used to pick the correct pose when a single tag has two near-equal
+     * PnP solutions (small or distant tags). Call every robot loop.
+     * @param yaw_deg  Field-relative heading in degrees (CCW positive)
+     */
+    void SetRobotYaw(double yaw_deg);
+
+    /**
+     * @brief Tell XNav whether the robot is enabled.
+     * While disabled (and low-power mode is configured on XNav), detection is
+     * skipped on a static scene to keep the coprocessor cool. Enabling the
+     * robot immediately restores full-rate processing.
+     */
+    void SetRobotEnabled(bool enabled);
+
+    // ── Camera mode ───────────────────────────────────────────────────────────
+
+    /**
+     * @brief Switch the XNav camera to a named mode preset.
+     * Presets are defined in the XNav camera config (e.g. a low-resolution,
+     * high-fps "close" mode for alignment). The switch happens in place on
+     * the running camera. An empty string returns to the configured mode.
+     */
+    void SetCameraMode(const std::string& mode);
+
     // ── Match mode ────────────────────────────────────────────────────────────
 
     /**
@@ -205,10 +241,21 @@ public:
 
     /**
      * @brief Register a callback invoked when new target data arrives.
-     * Called from NT listener thread.
+     * Called from NT listener thread (from SimTransport::Update() in
+     * simulation).
      */
     void OnNewTargets(std::function<void(const std::vector<TagResult>&)> callback);
 
+    // ── Simulation ────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Read results from a simulated camera instead of NetworkTables.
+     * All getters, including GetOffsetPoint, return the SimTransport's
+     * frames and OnNewTargets fires on its deliveries (see XNavSim.h);
+     * inputs (turret, mode, ...) are ignored. Pass nullptr to go back to NT.
+     */
+    void UseSimTransport(std::shared_ptr<SimTransport> sim);
+
 private:
     struct Impl;
     std::unique_ptr<Impl> m_impl;
@@ -0,0 +1,192 @@
+#pragma once
+/**
+ * XNavSim - Simulated XNav cameras for robot simulation
+ *
+ * Generates the TagResult / RobotPose frames XNav would publish, from the
+ * true robot pose of your physics simulation, a field tag layout and a
+ * camera model (resolution, FOV, mount). Frames are produced at each
+ * camera's frame rate and delivered after a configurable latency, with
+ * measurement noise and dropped frames, so vision-dependent code sees the
+ * same imperfections it sees on the field.
+ *
+ * Usage:
+ *   #include "XNavSim.h"
+ *
+ *   // In robotInit() (simulation only):
+ *   auto sim = std::make_shared<xnav::SimTransport>();
+ *   sim->SetFieldLayout({{1, 15.08, 0.25, 1.36, 0.5, 0.0, 0.0, 0.866}, ...});
+ *   xnav::SimCameraConfig cam;
+ *   cam.x_offset = 0.3; cam.z_offset = 0.5;
+ *   cam.roll = -90.0; cam.yaw = -90.0;   // level, facing forward
+ *   sim->AddCamera(cam);
+ *   m_vision.UseSimTransport(sim);
+ *
+ *   // In simulationPeriodic():
+ *   sim->Update(frc::Timer::GetFPGATimestamp().value(), m_driveSim.GetPose());
+ *
+ * All XNav getters (HasTarget, GetAllTargets, GetRobotPose, GetOffsetPoint,
+ * ...) then read the simulated frames instead of NetworkTables, and
+ * OnNewTargets callbacks fire from Update() as frames are delivered. The
+ * offset point is configured on the sim (SetOffsetPoint), as on the
+ * dashboard for the real device.
+ */
+
+#include "XNavLib.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace xnav {
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Configuration
+// ─────────────────────────────────────────────────────────────────────────────
+
+/** One tag of the field layout (same fields as a .fmap entry). */
+struct SimFieldTag {
+    int    id = -1;
+    double x  = 0.0;   ///< Field position (meters)
+    double y  = 0.0;
+    double z  = 0.0;
+    double qw = 1.0;   ///< Field orientation quaternion (WPILib: x out of the tag face)
+    double qx = 0.0;
+    double qy = 0.0;
+    double qz = 0.0;
+};
+
+/** Camera model, mount and error model of one simulated camera. */
+struct SimCameraConfig {
+    std::string name = "sim";
+    int    width    = 1280;
+    int    height   = 720;
+    double hfov_deg = 70.0;    ///< Horizontal field of view (degrees), square pixels
+    double fps      = 60.0;
+
+    // Mount: same fields and conventions as the XNav camera_mount config.
+    // The rotation R = Rz(yaw) * Ry(pitch) * Rx(roll) turns the camera's
+    // optical frame (x right, y down, z forward) into the robot frame, so
+    // all-zero angles look straight up. Level, facing the robot's front,
+    // upright image: roll = -90, pitch = 0, yaw = -90. Tilted up by a
+    // degrees: roll = -90 + a. Facing a heading h (CCW from the front):
+    // yaw = -90 + h (yaw = 90 faces the rear).
+    double x_offset = 0.0;     ///< meters
+    double y_offset = 0.0;
+    double z_offset = 0.0;
+    double roll     = 0.0;     ///< degrees
+    double pitch    = 0.0;
+    double yaw      = 0.0;
+
+    double tag_size_m = 0.1524;
+
+    // Visibility limits
+    double max_range_m        = 8.0;
+    double max_view_angle_deg = 75.0;  ///< Tags seen more obliquely are not detected
+    double min_tag_px         = 12.0;  ///< Smallest detectable tag (pixels, largest side)
+
+    // Timing
+    double latency_ms        = 30.0;   ///< Capture → result available
+    double latency_jitter_ms = 3.0;    ///< Std-dev of the latency
+    double dropout_rate      = 0.0;    ///< Fraction of frames lost (0..1)
+
+    // Noise (standard deviations); range-dependent terms scale with distance²
+    double angle_noise_deg = 0.05;     ///< tx / ty
+    double distance_noise  = 0.005;    ///< Range error per m² of range (m)
+    double rotation_noise_deg = 1.0;   ///< Tag yaw / pitch / roll
+    double pose_noise_m    = 0.01;     ///< Robot x / y / z per m² to the closest tag
+    double pose_noise_deg  = 0.2;      ///< Robot heading per m² to the closest tag
+};
+
+/** One delivered frame of a simulated camera. */
+struct SimFrame {
+    int      camera   = -1;
+    uint64_t sequence = 0;           ///< Frame counter of this camera (gaps = dropouts)
+    double   capture_time_s = 0.0;   ///< Sim time the frame was captured
+    double   latency_ms     = 0.0;   ///< Capture → delivery
+    std::vector<TagResult> tags;
+    RobotPose pose;                  ///< valid=false when no tag was seen
+    OffsetPoint offset;              ///< valid=false when the anchor tag was not seen
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// SimTransport
+// ─────────────────────────────────────────────────────────────────────────────
+
+class SimTransport {
+public:
+    /** @param seed  Noise / dropout RNG seed (fixed seed = repeatable runs) */
+    explicit SimTransport(uint32_t seed = 5805);
+    ~SimTransport();
+
+    /** Replace the field tag layout. */
+    void SetFieldLayout(std::vector<SimFieldTag> tags);
+
+    /**
+     * @brief Aim at a point relative to a tag (XNav's offset_point config).
+     * @param tag_id   Anchor tag; -1 disables the offset point
+     * @param x,y,z    Offset in the tag frame (meters; x right, y down, z into the face)
+     */
+    void SetOffsetPoint(int tag_id, double x, double y, double z);
+
+    /** Add a camera; returns its index. Multiple cameras are merged like on XNav. */
+    int AddCamera(const SimCameraConfig& config);
+
+    /**
+     * @brief Advance the simulation; call every sim loop.
+     * Captures every frame due since the last call (robot pose interpolated
+     * between calls) and delivers those whose latency has elapsed.
+     * @param time_s      Sim time in seconds (monotonic; going back resets)
+     * @param robot_pose  True robot pose (field frame, degrees)
+     * @return Number of frames delivered by this call.
+     * The OnNewTargets callback runs from this call after delivery.
+     */
+    int Update(double time_s, const RobotPose& robot_pose);
+
+#ifdef WPILIB_AVAILABLE
+    int Update(double time_s, const frc::Pose3d& robot_pose) {
+        RobotPose p;
+        p.x       = robot_pose.X().value();
+        p.y       = robot_pose.Y().value();
+        p.z       = robot_pose.Z().value();
+        p.roll    = units::degree_t(robot_pose.Rotation().X()).value();
+        p.pitch   = units::degree_t(robot_pose.Rotation().Y()).value();
+        p.yaw_deg = units::degree_t(robot_pose.Rotation().Z()).value();
+        p.valid   = true;
+        return Update(time_s, p);
+    }
+
+    int Update(double time_s, const frc::Pose2d& robot_pose) {
+        return Update(time_s, frc::Pose3d(robot_pose));
+    }
+#endif
+
+    /** Drop all pending and delivered frames (e.g. on sim reset). */
+    void Reset();
+
+    /** Tags of the latest frame of every camera, closest per id, sorted by id. */
+    std::vector<TagResult> GetTargets() const;
+
+    /** Robot pose of the most recent frame (valid=false if it saw no tag). */
+    RobotPose GetRobotPose() const;
+
+    /** Offset point of the most recent frame (valid=false if the anchor was not seen). */
+    OffsetPoint GetOffsetPoint() const;
+
+    /** Callback invoked with GetTargets() after an Update() that delivered frames. */
+    void OnNewTargets(std::function<void(const std::vector<TagResult>&)> callback);
+
+    /** Latest delivered frame of one camera. */
+    std::optional<SimFrame> GetLatestFrame(int camera) const;
+
+    /** Status as XNav would report it (delivered fps, latency). */
+    SystemStatus GetStatus() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+} // namespace xnav
@@ -6,6 +6,7 @@
  */
 
 #include "XNavLib.h"
+#include "XNavSim.h"
 
 #include <sstream>
 #include <mutex>
@@ -32,6 +33,7 @@ struct XNav::Impl {
     std::string table_name;
     std::function<void(const std::vector<TagResult>&)> on_new_targets;
     mutable std::mutex data_mutex;
+    std::shared_ptr<SimTransport> sim;
 
 #ifdef WPILIB_AVAILABLE
     nt::NetworkTableInstance inst;
@@ -45,6 +47,12 @@ struct XNav::Impl {
     nt::DoubleSubscriber   sub_fps;
     nt::DoubleSubscriber   sub_latency;
     nt::DoubleArraySubscriber sub_robot_pose;
+    // Thermal
+    nt::DoubleSubscriber   sub_temperature, sub_time_to_throttle;
+    nt::BooleanSubscriber  sub_thermal_throttled;
+    // Quality controller
+    nt::IntegerSubscriber  sub_quality_level;
+    nt::DoubleSubscriber   sub_quad_decimate;
     // Offset point
     nt::BooleanSubscriber  sub_offset_valid;
     nt::DoubleSubscriber   sub_offset_x, sub_offset_y, sub_offset_z;
@@ -55,10 +63,13 @@ struct XNav::Impl {
     nt::DoublePublisher  pub_turret_angle;
     nt::BooleanPublisher pub_turret_enabled;
     nt::BooleanPublisher pub_match_mode;
+    nt::DoublePublisher  pub_robot_yaw;
+    nt::BooleanPublisher pub_robot_enabled;
+    nt::StringPublisher  pub_camera_mode;
 
     // Per-tag subscribers (created lazily)
     struct TagSubs {
-        nt::DoubleSubscriber tx, ty, x, y, z, distance, yaw, pitch, roll;
+        nt::DoubleSubscriber tx, ty, x, y, z, distance, yaw, pitch, roll, ambiguity;
     };
     std::unordered_map<int, TagSubs> tag_subs;
     nt::IntegerArraySubscriber sub_tag_ids;
@@ -76,6 +87,15 @@ struct XNav::Impl {
         sub_robot_pose  = table->GetDoubleArrayTopic("robotPose").Subscribe({});
         sub_tag_ids     = table->GetIntegerArrayTopic("tagIds").Subscribe({});
 
+        auto thermal = table->GetSubTable("thermal");
+        sub_temperature       = thermal->GetDoubleTopic("temperatureC").Subscribe(0.0);
+        sub_time_to_throttle  = thermal->GetDoubleTopic("timeToThrottleS").Subscribe(-1.0);
+        sub_thermal_throttled = thermal->GetBooleanTopic("throttled").Subscribe(false);
+
+        auto quality = table->GetSubTable("quality");
+        sub_quality_level = quality->GetIntegerTopic("level").Subscribe(0);
+        sub_quad_decimate = quality->GetDoubleTopic("quadDecimate").Subscribe(0.0);
+
         auto op = table->GetSubTable("offsetPoint");
         sub_offset_valid  = op->GetBooleanTopic("valid").Subscribe(false);
         sub_offset_x      = op->GetDoubleTopic("x").Subscribe(0.0);
@@ -90,6 +110,9 @@ struct XNav::Impl {
         pub_turret_angle   = input->GetDoubleTopic("turretAngle").Publish();
         pub_turret_enabled = input->GetBooleanTopic("turretEnabled").Publish();
         pub_match_mode     = input->GetBooleanTopic("matchMode").Publish();
+        pub_robot_yaw      = input->GetDoubleTopic("robotYaw").Publish();
+        pub_robot_enabled  = input->GetBooleanTopic("robotEnabled").Publish();
+        pub_camera_mode    = input->GetStringTopic("cameraMode").Publish();
 
         if (!server.empty()) {
             inst.SetServer(server.c_str());
@@ -111,6 +134,7 @@ struct XNav::Impl {
         ts.yaw      = sub->GetDoubleTopic("yaw").Subscribe(0.0);
         ts.pitch    = sub->GetDoubleTopic("pitch").Subscribe(0.0);
         ts.roll     = sub->GetDoubleTopic("roll").Subscribe(0.0);
+        ts.ambiguity = sub->GetDoubleTopic("ambiguity").Subscribe(0.0);
         tag_subs[id] = std::move(ts);
         return tag_subs[id];
     }
@@ -128,6 +152,7 @@ struct XNav::Impl {
         t.yaw      = ts.yaw.Get();
         t.pitch    = ts.pitch.Get();
         t.roll     = ts.roll.Get();
+        t.ambiguity = ts.ambiguity.Get();
         return t;
     }
 #else
@@ -157,6 +182,7 @@ void XNav::Init(const std::string& server_address) {
 }
 
 bool XNav::HasTarget() const {
+    if (m_impl->sim) return !m_impl->sim->GetTargets().empty();
 #ifdef WPILIB_AVAILABLE
     return m_impl->sub_has_target.Get();
 #else
@@ -165,6 +191,7 @@ bool XNav::HasTarget() const {
 }
 
 int XNav::GetNumTargets() const {
+    if (m_impl->sim) return static_cast<int>(m_impl->sim->GetTargets().size());
 #ifdef WPILIB_AVAILABLE
     return static_cast<int>(m_impl->sub_num_targets.Get());
 #else
@@ -173,6 +200,11 @@ int XNav::GetNumTargets() const {
 }
 
 std::vector<int> XNav::GetTagIds() const {
+    if (m_impl->sim) {
+        std::vector<int> ids;
+        for (const auto& t : m_impl->sim->GetTargets()) ids.push_back(t.id);
+        return ids;
+    }
 #ifdef WPILIB_AVAILABLE
     auto raw = m_impl->sub_tag_ids.Get();
     std::vector<int> ids;
@@ -185,6 +217,12 @@ std::vector<int> XNav::GetTagIds() const {
 }
 
 TagResult XNav::GetPrimaryTarget() const {
+    if (m_impl->sim) {
+        auto tags = m_impl->sim->GetTargets();
+        auto it = std::min_element(tags.begin(), tags.end(),
+            [](const TagResult& a, const TagResult& b) { return a.distance < b.distance; });
+        return it != tags.end() ? *it : TagResult{};
+    }
 #ifdef WPILIB_AVAILABLE
     int id = static_cast<int>(m_impl->sub_primary_id.Get(-1));
     if (id < 0) return TagResult{};
@@ -195,6 +233,12 @@ TagResult XNav::GetPrimaryTarget() const {
 }
 
 std::optional<TagResult> XNav::GetTarget(int tag_id) const {
+    if (m_impl->sim) {
+        for (const auto& t : m_impl->sim->GetTargets()) {
+            if (t.id == tag_id) return t;
+        }
+        return std::nullopt;
+    }
 #ifdef WPILIB_AVAILABLE
     auto ids = GetTagIds();
     auto it = std::find(ids.begin(), ids.end(), tag_id);
@@ -206,6 +250,7 @@ std::optional<TagResult> XNav::GetTarget(int tag_id) const {
 }
 
 std::vector<TagResult> XNav::GetAllTargets() const {
+    if (m_impl->sim) return m_impl->sim->GetTargets();
     std::vector<TagResult> results;
     for (int id : GetTagIds()) {
         results.push_back(m_impl->ReadTag(id));
@@ -214,6 +259,7 @@ std::vector<TagResult> XNav::GetAllTargets() const {
 }
 
 RobotPose XNav::GetRobotPose() const {
+    if (m_impl->sim) return m_impl->sim->GetRobotPose();
     RobotPose pose;
 #ifdef WPILIB_AVAILABLE
     auto data = m_impl->sub_robot_pose.Get({});
@@ -231,6 +277,7 @@ RobotPose XNav::GetRobotPose() const {
 }
 
 OffsetPoint XNav::GetOffsetPoint() const {
+    if (m_impl->sim) return m_impl->sim->GetOffsetPoint();
     OffsetPoint op;
 #ifdef WPILIB_AVAILABLE
     op.valid           = m_impl->sub_offset_valid.Get(false);
@@ -263,7 +310,26 @@ void XNav::SetMatchMode(bool enabled) {
 #endif
 }
 
+void XNav::SetRobotYaw(double yaw_deg) {
+#ifdef WPILIB_AVAILABLE
+    m_impl->pub_robot_yaw.Set(yaw_deg);
+#endif
+}
+
+void XNav::SetRobotEnabled(bool enabled) {
+#ifdef WPILIB_AVAILABLE
+    m_impl->pub_robot_enabled.Set(enabled);
+#endif
+}
+
+void XNav::SetCameraMode(const std::string& mode) {
+#ifdef WPILIB_AVAILABLE
+    m_impl->pub_camera_mode.Set(mode);
+#endif
+}
+
 SystemStatus XNav::GetStatus() const {
+    if (m_impl->sim) return m_impl->sim->GetStatus();
     SystemStatus s;
 #ifdef WPILIB_AVAILABLE
     s.status      = m_impl->sub_status.Get("unknown");
@@ -271,11 +337,17 @@ SystemStatus XNav::GetStatus() const {
     s.latency_ms  = m_impl->sub_latency.Get(0.0);
     s.num_targets = GetNumTargets();
     s.nt_connected = IsConnected();
+    s.temperature_c      = m_impl->sub_temperature.Get(0.0);
+    s.time_to_throttle_s = m_impl->sub_time_to_throttle.Get(-1.0);
+    s.thermal_throttled  = m_impl->sub_thermal_throttled.Get(false);
+    s.quality_level      = static_cast<int>(m_impl->sub_quality_level.Get(0));
+    s.quad_decimate      = m_impl->sub_quad_decimate.Get(0.0);
 #endif
     return s;
 }
 
 bool XNav::IsConnected() const {
+    if (m_impl->sim) return true;
 #ifdef WPILIB_AVAILABLE
     return !m_impl->inst.GetConnections().empty();
 #else
@@ -285,6 +357,13 @@ bool XNav::IsConnected() const {
 
 void XNav::OnNewTargets(std::function<void(const std::vector<TagResult>&)> callback) {
     m_impl->on_new_targets = std::move(callback);
+    if (m_impl->sim) m_impl->sim->OnNewTargets(m_impl->on_new_targets);
+}
+
+void XNav::UseSimTransport(std::shared_ptr<SimTransport> sim) {
+    if (m_impl->sim) m_impl->sim->OnNewTargets(nullptr);
+    m_impl->sim = std::move(sim);
+    if (m_impl->sim) m_impl->sim->OnNewTargets(m_impl->on_new_targets);
 }
 
 } // namespace xnav
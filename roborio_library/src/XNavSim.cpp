@@ -0,0 +1,456 @@
+/**
+ * XNavSim.cpp - Simulated XNav cameras.
+ *
+ * Uses the same frame chain as XNav's pose calculator, so simulated tags
+ * and poses have the conventions of the real device:
+ *   camera_in_field = robot_in_field * camera_to_robot(mount)
+ *   tag_in_camera   = inv(camera_in_field) * tag_in_field
+ */
+
+#include "XNavSim.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+
+namespace xnav {
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Rigid transforms
+// ─────────────────────────────────────────────────────────────────────────────
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kDeg = kPi / 180.0;
+// Tags closer than this (meters, camera Z) are treated as not visible
+constexpr double kNearPlane = 0.05;
+// A gap longer than this between Update() calls (paused sim) skips frames
+constexpr double kMaxCatchUpS = 0.5;
+
+/** 3x3 rotation + translation. */
+struct Transform {
+    double R[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+    double t[3]    = {0, 0, 0};
+
+    Transform operator*(const Transform& o) const {
+        Transform out;
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                out.R[i][j] = R[i][0] * o.R[0][j] + R[i][1] * o.R[1][j] + R[i][2] * o.R[2][j];
+            }
+            out.t[i] = R[i][0] * o.t[0] + R[i][1] * o.t[1] + R[i][2] * o.t[2] + t[i];
+        }
+        return out;
+    }
+
+    Transform Inverse() const {
+        Transform out;
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) out.R[i][j] = R[j][i];
+        }
+        for (int i = 0; i < 3; ++i) {
+            out.t[i] = -(out.R[i][0] * t[0] + out.R[i][1] * t[1] + out.R[i][2] * t[2]);
+        }
+        return out;
+    }
+
+    void Apply(const double p[3], double out[3]) const {
+        for (int i = 0; i < 3; ++i) {
+            out[i] = R[i][0] * p[0] + R[i][1] * p[1] + R[i][2] * p[2] + t[i];
+        }
+    }
+};
+
+/** R = Rz(yaw) * Ry(pitch) * Rx(roll), degrees (XNav mount / pose convention). */
+Transform FromEuler(double x, double y, double z, double roll, double pitch, double yaw) {
+    const double cr = std::cos(roll * kDeg), sr = std::sin(roll * kDeg);
+    const double cp = std::cos(pitch * kDeg), sp = std::sin(pitch * kDeg);
+    const double cy = std::cos(yaw * kDeg), sy = std::sin(yaw * kDeg);
+    Transform T;
+    T.R[0][0] = cy * cp; T.R[0][1] = cy * sp * sr - sy * cr; T.R[0][2] = cy * sp * cr + sy * sr;
+    T.R[1][0] = sy * cp; T.R[1][1] = sy * sp * sr + cy * cr; T.R[1][2] = sy * sp * cr - cy * sr;
+    T.R[2][0] = -sp;     T.R[2][1] = cp * sr;                T.R[2][2] = cp * cr;
+    T.t[0] = x; T.t[1] = y; T.t[2] = z;
+    return T;
+}
+
+/**
+ * Detector tag frame in the field from a .fmap pose (as _tag_in_field in
+ * XNav's pose calculator). The .fmap orientation is WPILib's (x out of the
+ * tag face, z up); the detector's frame, seen from the front, has x right
+ * (WPILib +y), y down (-z) and z into the face (-x).
+ */
+Transform FromQuaternion(const SimFieldTag& tag) {
+    const double n = std::sqrt(tag.qw * tag.qw + tag.qx * tag.qx + tag.qy * tag.qy + tag.qz * tag.qz);
+    const double w = tag.qw / n, x = tag.qx / n, y = tag.qy / n, z = tag.qz / n;
+    const double R[3][3] = {
+        {1 - 2 * (y * y + z * z), 2 * (x * y - z * w),     2 * (x * z + y * w)},
+        {2 * (x * y + z * w),     1 - 2 * (x * x + z * z), 2 * (y * z - x * w)},
+        {2 * (x * z - y * w),     2 * (y * z + x * w),     1 - 2 * (x * x + y * y)},
+    };
+    Transform T;
+    for (int i = 0; i < 3; ++i) {
+        T.R[i][0] = R[i][1];
+        T.R[i][1] = -R[i][2];
+        T.R[i][2] = -R[i][0];
+    }
+    T.t[0] = tag.x; T.t[1] = tag.y; T.t[2] = tag.z;
+    return T;
+}
+
+double WrapDeg(double a) {
+    a = std::fmod(a + 180.0, 360.0);
+    return (a < 0 ? a + 360.0 : a) - 180.0;
+}
+
+RobotPose Interpolate(const RobotPose& a, const RobotPose& b, double f) {
+    RobotPose p;
+    p.x       = a.x + (b.x - a.x) * f;
+    p.y       = a.y + (b.y - a.y) * f;
+    p.z       = a.z + (b.z - a.z) * f;
+    p.roll    = a.roll + WrapDeg(b.roll - a.roll) * f;
+    p.pitch   = a.pitch + WrapDeg(b.pitch - a.pitch) * f;
+    p.yaw_deg = a.yaw_deg + WrapDeg(b.yaw_deg - a.yaw_deg) * f;
+    p.valid   = true;
+    return p;
+}
+
+} // namespace
+
+// ─────────────────────────────────────────────────────────────────────────────
+// PIMPL implementation
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct SimTransport::Impl {
+    struct Pending {
+        double   deliver_s;
+        SimFrame frame;
+    };
+
+    struct Camera {
+        SimCameraConfig cfg;
+        Transform camera_to_robot;
+        double fx = 0.0, cx = 0.0, cy = 0.0;
+        double min_cos_view = 0.0;
+        double corners[4][3] = {};
+
+        double   next_capture_s = -1.0;
+        double   last_deliver_s = -1.0;
+        uint64_t sequence = 0;
+        std::deque<Pending> pending;
+        std::optional<SimFrame> latest;
+        double   interval_s = 0.0;   ///< Delivered frame interval (smoothed)
+    };
+
+    mutable std::mutex mutex;
+    std::mt19937 rng;
+    std::normal_distribution<double> normal{0.0, 1.0};
+    std::uniform_real_distribution<double> uniform{0.0, 1.0};
+
+    std::vector<std::pair<int, Transform>> tags;
+    std::vector<Camera> cameras;
+
+    int    offset_tag = -1;
+    double offset[3] = {0.0, 0.0, 0.0};
+    std::function<void(const std::vector<TagResult>&)> on_new_targets;
+
+    bool      have_last = false;
+    double    last_time_s = 0.0;
+    RobotPose last_pose;
+
+    explicit Impl(uint32_t seed) : rng(seed) {}
+
+    double Noise(double sigma) { return sigma > 0.0 ? normal(rng) * sigma : 0.0; }
+
+    void ResetFrames() {
+        for (auto& cam : cameras) {
+            cam.next_capture_s = -1.0;
+            cam.last_deliver_s = -1.0;
+            cam.pending.clear();
+            cam.latest.reset();
+            cam.interval_s = 0.0;
+        }
+        have_last = false;
+    }
+
+    /** Most recently captured delivered frame of any camera (the one XNav
+     *  would have published last), or nullptr before the first delivery. */
+    const SimFrame* Newest() const {
+        const SimFrame* newest = nullptr;
+        for (const auto& cam : cameras) {
+            if (cam.latest && (!newest || cam.latest->capture_time_s > newest->capture_time_s)) {
+                newest = &*cam.latest;
+            }
+        }
+        return newest;
+    }
+
+    /** What camera `index` sees from `robot`, with noise. */
+    SimFrame Capture(int index, const RobotPose& robot, double time_s) {
+        Camera& cam = cameras[index];
+        const SimCameraConfig& cfg = cam.cfg;
+
+        SimFrame frame;
+        frame.camera = index;
+        frame.sequence = cam.sequence;
+        frame.capture_time_s = time_s;
+
+        const Transform robot_in_field =
+            FromEuler(robot.x, robot.y, robot.z, robot.roll, robot.pitch, robot.yaw_deg);
+        const Transform field_to_camera = (robot_in_field * cam.camera_to_robot).Inverse();
+
+        double closest = 0.0;
+        for (const auto& [id, tag_in_field] : tags) {
+            const Transform tag = field_to_camera * tag_in_field;
+            const double dist = std::sqrt(tag.t[0] * tag.t[0] + tag.t[1] * tag.t[1] + tag.t[2] * tag.t[2]);
+            if (dist > cfg.max_range_m || dist < 1e-6) continue;
+            // Tag +Z points away from the camera when its face is visible
+            const double cos_view = (tag.R[0][2] * tag.t[0] + tag.R[1][2] * tag.t[1] + tag.R[2][2] * tag.t[2]) / dist;
+            if (cos_view < cam.min_cos_view) continue;
+
+            // All four corners in front of the camera and inside the image
+            double u0 = 1e9, u1 = -1e9, v0 = 1e9, v1 = -1e9;
+            bool visible = true;
+            for (const auto& corner : cam.corners) {
+                double p[3];
+                tag.Apply(corner, p);
+                if (p[2] < kNearPlane) { visible = false; break; }
+                const double u = cam.fx * p[0] / p[2] + cam.cx;
+                const double v = cam.fx * p[1] / p[2] + cam.cy;
+                u0 = std::min(u0, u); u1 = std::max(u1, u);
+                v0 = std::min(v0, v); v1 = std::max(v1, v);
+            }
+            if (!visible || u0 < 0 || v0 < 0 || u1 >= cfg.width || v1 >= cfg.height) continue;
+            const double side_px = std::max(u1 - u0, v1 - v0);
+            if (side_px < cfg.min_tag_px) continue;
+
+            // Noisy bearing and range, then back to a camera-frame position
+            TagResult r;
+            r.id = id;
+            r.tx = std::atan2(tag.t[0], tag.t[2]) / kDeg + Noise(cfg.angle_noise_deg);
+            r.ty = -std::atan2(tag.t[1], tag.t[2]) / kDeg + Noise(cfg.angle_noise_deg);
+            r.distance = std::max(kNearPlane, dist + Noise(cfg.distance_noise * dist * dist));
+            const double tan_x = std::tan(r.tx * kDeg), tan_y = std::tan(r.ty * kDeg);
+            r.z = r.distance / std::sqrt(1.0 + tan_x * tan_x + tan_y * tan_y);
+            r.x = r.z * tan_x;
+            r.y = -r.z * tan_y;
+
+            r.roll  = std::atan2(tag.R[2][1], tag.R[2][2]) / kDeg + Noise(cfg.rotation_noise_deg);
+            r.pitch = std::atan2(-tag.R[2][0], std::hypot(tag.R[2][1], tag.R[2][2])) / kDeg
+                      + Noise(cfg.rotation_noise_deg);
+            r.yaw   = std::atan2(tag.R[1][0], tag.R[0][0]) / kDeg + Noise(cfg.rotation_noise_deg);
+            // Small tags in the image are the ones with two near-equal PnP solutions
+            const double rel = 2.0 * cfg.min_tag_px / side_px;
+            r.ambiguity = std::min(1.0, rel * rel);
+
+            if (id == offset_tag) {
+                // Measured tag position, true orientation (as the device's
+                // compute_offset_point: t + R * offset)
+                OffsetPoint& op = frame.offset;
+                op.tag_id = id;
+                op.x = r.x + tag.R[0][0] * offset[0] + tag.R[0][1] * offset[1] + tag.R[0][2] * offset[2];
+                op.y = r.y + tag.R[1][0] * offset[0] + tag.R[1][1] * offset[1] + tag.R[1][2] * offset[2];
+                op.z = r.z + tag.R[2][0] * offset[0] + tag.R[2][1] * offset[1] + tag.R[2][2] * offset[2];
+                op.direct_distance = std::sqrt(op.x * op.x + op.y * op.y + op.z * op.z);
+                op.tx = std::atan2(op.x, op.z) / kDeg;
+                op.ty = -std::atan2(op.y, op.z) / kDeg;
+                op.valid = true;
+            }
+
+            if (frame.tags.empty() || dist < closest) closest = dist;
+            frame.tags.push_back(r);
+        }
+
+        std::sort(frame.tags.begin(), frame.tags.end(),
+                  [](const TagResult& a, const TagResult& b) { return a.id < b.id; });
+
+        if (!frame.tags.empty()) {
+            // Multi-tag solves average the error down
+            const double scale = closest * closest / std::sqrt(static_cast<double>(frame.tags.size()));
+            frame.pose.x       = robot.x + Noise(cfg.pose_noise_m * scale);
+            frame.pose.y       = robot.y + Noise(cfg.pose_noise_m * scale);
+            frame.pose.z       = robot.z + Noise(cfg.pose_noise_m * scale);
+            frame.pose.roll    = robot.roll;
+            frame.pose.pitch   = robot.pitch;
+            frame.pose.yaw_deg = WrapDeg(robot.yaw_deg + Noise(cfg.pose_noise_deg * scale));
+            frame.pose.valid   = true;
+        }
+        return frame;
+    }
+
+    int Advance(double time_s, const RobotPose& robot) {
+        if (have_last && time_s < last_time_s) {
+            ResetFrames();
+        }
+        const RobotPose prev = have_last ? last_pose : robot;
+        const double prev_s = have_last ? last_time_s : time_s;
+
+        int delivered = 0;
+        for (size_t i = 0; i < cameras.size(); ++i) {
+            Camera& cam = cameras[i];
+            const double period = 1.0 / std::max(1.0, cam.cfg.fps);
+            if (cam.next_capture_s < 0.0 || time_s - cam.next_capture_s > kMaxCatchUpS) {
+                cam.next_capture_s = time_s;
+            }
+
+            for (; cam.next_capture_s <= time_s; cam.next_capture_s += period, ++cam.sequence) {
+                if (uniform(rng) < cam.cfg.dropout_rate) continue;
+                const double span = time_s - prev_s;
+                const double f = span > 0.0 ? std::clamp((cam.next_capture_s - prev_s) / span, 0.0, 1.0) : 1.0;
+                const RobotPose at = Interpolate(prev, robot, f);
+
+                Pending p;
+                p.frame = Capture(static_cast<int>(i), at, cam.next_capture_s);
+                const double latency_s =
+                    std::max(0.0, cam.cfg.latency_ms + Noise(cam.cfg.latency_jitter_ms)) / 1000.0;
+                // Frames are processed in order: one never overtakes the previous
+                p.deliver_s = std::max(cam.next_capture_s + latency_s,
+                                       cam.pending.empty() ? 0.0 : cam.pending.back().deliver_s);
+                p.frame.latency_ms = (p.deliver_s - p.frame.capture_time_s) * 1000.0;
+                cam.pending.push_back(std::move(p));
+            }
+
+            while (!cam.pending.empty() && cam.pending.front().deliver_s <= time_s) {
+                Pending& p = cam.pending.front();
+                if (cam.last_deliver_s >= 0.0) {
+                    const double dt = p.deliver_s - cam.last_deliver_s;
+                    cam.interval_s = cam.interval_s > 0.0 ? cam.interval_s * 0.9 + dt * 0.1 : dt;
+                }
+                cam.last_deliver_s = p.deliver_s;
+                cam.latest = std::move(p.frame);
+                cam.pending.pop_front();
+                ++delivered;
+            }
+        }
+
+        have_last = true;
+        last_time_s = time_s;
+        last_pose = robot;
+        return delivered;
+    }
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// SimTransport public API
+// ─────────────────────────────────────────────────────────────────────────────
+
+SimTransport::SimTransport(uint32_t seed)
+    : m_impl(std::make_unique<Impl>(seed)) {}
+
+SimTransport::~SimTransport() = default;
+
+void SimTransport::SetFieldLayout(std::vector<SimFieldTag> tags) {
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    m_impl->tags.clear();
+    m_impl->tags.reserve(tags.size());
+    for (const auto& tag : tags) {
+        m_impl->tags.emplace_back(tag.id, FromQuaternion(tag));
+    }
+}
+
+int SimTransport::AddCamera(const SimCameraConfig& config) {
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    Impl::Camera cam;
+    cam.cfg = config;
+    cam.camera_to_robot = FromEuler(config.x_offset, config.y_offset, config.z_offset,
+                                    config.roll, config.pitch, config.yaw);
+    cam.fx = (config.width / 2.0) / std::tan(config.hfov_deg * kDeg / 2.0);
+    cam.cx = config.width / 2.0;
+    cam.cy = config.height / 2.0;
+    cam.min_cos_view = std::cos(config.max_view_angle_deg * kDeg);
+    // Same corner order as the XNav detector's PnP object points
+    const double s = config.tag_size_m / 2.0;
+    const double corners[4][3] = {{-s, s, 0}, {s, s, 0}, {s, -s, 0}, {-s, -s, 0}};
+    std::copy(&corners[0][0], &corners[0][0] + 12, &cam.corners[0][0]);
+    m_impl->cameras.push_back(std::move(cam));
+    return static_cast<int>(m_impl->cameras.size()) - 1;
+}
+
+void SimTransport::SetOffsetPoint(int tag_id, double x, double y, double z) {
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    m_impl->offset_tag = tag_id;
+    m_impl->offset[0] = x;
+    m_impl->offset[1] = y;
+    m_impl->offset[2] = z;
+}
+
+int SimTransport::Update(double time_s, const RobotPose& robot_pose) {
+    int delivered;
+    std::function<void(const std::vector<TagResult>&)> callback;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        delivered = m_impl->Advance(time_s, robot_pose);
+        callback = m_impl->on_new_targets;
+    }
+    // Outside the lock: the callback may call back into the getters
+    if (delivered > 0 && callback) callback(GetTargets());
+    return delivered;
+}
+
+void SimTransport::Reset() {
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    m_impl->ResetFrames();
+}
+
+std::vector<TagResult> SimTransport::GetTargets() const {
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    std::map<int, TagResult> closest;
+    for (const auto& cam : m_impl->cameras) {
+        if (!cam.latest) continue;
+        for (const auto& tag : cam.latest->tags) {
+            auto it = closest.find(tag.id);
+            if (it == closest.end() || tag.distance < it->second.distance) closest[tag.id] = tag;
+        }
+    }
+    std::vector<TagResult> out;
+    out.reserve(closest.size());
+    for (const auto& [id, tag] : closest) out.push_back(tag);
+    return out;
+}
+
+RobotPose SimTransport::GetRobotPose() const {
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    const SimFrame* newest = m_impl->Newest();
+    return newest ? newest->pose : RobotPose{};
+}
+
+OffsetPoint SimTransport::GetOffsetPoint() const {
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    const SimFrame* newest = m_impl->Newest();
+    return newest ? newest->offset : OffsetPoint{};
+}
+
+void SimTransport::OnNewTargets(std::function<void(const std::vector<TagResult>&)> callback) {
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    m_impl->on_new_targets = std::move(callback);
+}
+
+std::optional<SimFrame> SimTransport::GetLatestFrame(int camera) const {
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    if (camera < 0 || camera >= static_cast<int>(m_impl->cameras.size())) return std::nullopt;
+    return m_impl->cameras[camera].latest;
+}
+
+SystemStatus SimTransport::GetStatus() const {
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    SystemStatus s;
+    s.status = "starting";
+    std::set<int> ids;
+    for (const auto& cam : m_impl->cameras) {
+        if (!cam.latest) continue;
+        s.status = "running";
+        if (cam.interval_s > 0.0) s.fps = std::max(s.fps, 1.0 / cam.interval_s);
+        s.latency_ms = std::max(s.latency_ms, cam.latest->latency_ms);
+        for (const auto& tag : cam.latest->tags) ids.insert(tag.id);
+    }
+    s.num_targets = static_cast<int>(ids.size());
+    s.nt_connected = true;
+    return s;
+}
+
+} // namespace xnav
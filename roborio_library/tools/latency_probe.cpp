@@ -0,0 +1,59 @@
+/**
+ * latency_probe.cpp - Client end of the XNav latency rig.
+ *
+ * Polls the XNavLib getters as robot code would and prints each newly seen
+ * primary tag id with its CLOCK_MONOTONIC time in nanoseconds:
+ *   ready
+ *   <tag id> <time ns>
+ * vision_core/tools/latency_rig.py injects frames whose tag id is the frame
+ * counter and matches these lines against its injection times.
+ *
+ * Usage: xnav_latency_probe [server] [seconds] [poll_us]
+ */
+
+#include "XNavLib.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+int main(int argc, char** argv) {
+    const std::string server = argc > 1 ? argv[1] : "127.0.0.1";
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 3600.0;
+    const int poll_us = argc > 3 ? std::atoi(argv[3]) : 200;
+
+#ifndef WPILIB_AVAILABLE
+    std::fprintf(stderr, "xnav_latency_probe: built without WPILib, nothing to measure\n");
+    return 1;
+#endif
+
+    xnav::XNav vision;
+    vision.Init(server);
+
+    using clock = std::chrono::steady_clock;   // CLOCK_MONOTONIC on Linux
+    const auto end = clock::now() + std::chrono::duration<double>(seconds);
+    const auto poll = std::chrono::microseconds(poll_us);
+
+    while (!vision.IsConnected()) {
+        if (clock::now() > end) return 1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::printf("ready\n");
+    std::fflush(stdout);
+
+    int last_id = -1;
+    while (clock::now() < end) {
+        const int id = vision.GetPrimaryTarget().id;
+        if (id >= 0 && id != last_id) {
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock::now().time_since_epoch()).count();
+            std::printf("%d %lld\n", id, static_cast<long long>(ns));
+            std::fflush(stdout);
+        }
+        last_id = id;
+        std::this_thread::sleep_for(poll);
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+#pragma once
+/**
+ * perf_counters.h - Hardware performance counters for the XNavLib tools.
+ *
+ * A perf_event_open group (cycles, instructions, cache misses, branch
+ * misses) for the calling thread, user space only so it works at the
+ * default perf_event_paranoid level. Where the PMU is not accessible (VMs,
+ * containers, non-Linux) available() is false and reads return zeros.
+ */
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace xnav::tools {
+
+class PerfCounters {
+public:
+    static constexpr int kNumEvents = 4;
+    static constexpr const char* kNames[kNumEvents] = {
+        "cycles", "instructions", "cache_misses", "branch_misses"};
+
+    using Counts = std::array<double, kNumEvents>;
+
+    PerfCounters() {
+#ifdef __linux__
+        const uint64_t configs[kNumEvents] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (int i = 0; i < kNumEvents; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED
+                               | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.disabled = i == 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            // pid 0, cpu -1: this thread on any CPU
+            const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1,
+                                                    i == 0 ? -1 : m_fds[0], 0));
+            if (fd < 0) {
+                Close();
+                return;
+            }
+            m_fds[i] = fd;
+        }
+        ioctl(m_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(m_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    ~PerfCounters() { Close(); }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return m_fds[0] >= 0; }
+
+    /** Cumulative counts, scaled up if the PMU was multiplexed. */
+    Counts Read() const {
+        Counts out{};
+#ifdef __linux__
+        if (!available()) return out;
+        uint64_t buf[3 + kNumEvents] = {};
+        if (read(m_fds[0], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf))) return out;
+        const double scale = buf[2] ? static_cast<double>(buf[1]) / buf[2] : 0.0;
+        for (int i = 0; i < kNumEvents; ++i) out[i] = buf[3 + i] * scale;
+#endif
+        return out;
+    }
+
+private:
+    void Close() {
+#ifdef __linux__
+        for (auto& fd : m_fds) {
+            if (fd >= 0) close(fd);
+            fd = -1;
+        }
+#endif
+    }
+
+    std::array<int, kNumEvents> m_fds{-1, -1, -1, -1};
+};
+
+} // namespace xnav::tools
@@ -0,0 +1,101 @@
+/**
+ * xnav_bench.cpp - XNavLib microbenchmarks.
+ *
+ * Times the calls robot code makes every loop (getters, through NT or a
+ * SimTransport) and the simulated camera update, reporting per call the
+ * wall time and, where perf_event_open is permitted, cycles, instructions,
+ * IPC, cache misses and branch misses.
+ *
+ * Usage: xnav_bench [iterations]
+ */
+
+#include "XNavLib.h"
+#include "XNavSim.h"
+#include "perf_counters.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+volatile double g_sink = 0.0;   // keeps results observable to the optimizer
+
+void Bench(xnav::tools::PerfCounters& perf, const std::string& name, int iterations,
+           const std::function<void(int)>& fn) {
+    for (int i = 0; i < iterations / 10; ++i) fn(i);   // warm-up
+
+    const auto c0 = perf.Read();
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) fn(i);
+    const auto t1 = std::chrono::steady_clock::now();
+    const auto c1 = perf.Read();
+
+    const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+    std::printf("%-26s %12.1f", name.c_str(), ns);
+    if (perf.available()) {
+        double per[xnav::tools::PerfCounters::kNumEvents];
+        for (int k = 0; k < xnav::tools::PerfCounters::kNumEvents; ++k) {
+            per[k] = (c1[k] - c0[k]) / iterations;
+        }
+        std::printf(" %12.0f %12.0f %8.2f %12.1f %12.1f", per[0], per[1],
+                    per[0] > 0 ? per[1] / per[0] : 0.0, per[2], per[3]);
+    }
+    std::printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+    xnav::tools::PerfCounters perf;
+
+    std::printf("%-26s %12s", "call", "ns");
+    if (perf.available()) {
+        std::printf(" %12s %12s %8s %12s %12s", "cycles", "instructions", "ipc",
+                    "cache_miss", "branch_miss");
+    } else {
+        std::printf("   (hardware counters unavailable)");
+    }
+    std::printf("\n");
+
+    // Getters straight from NT (defaults without a server; call overhead only)
+    xnav::XNav nt_vision;
+    nt_vision.Init("127.0.0.1");
+    Bench(perf, "nt HasTarget", iterations, [&](int) { g_sink = nt_vision.HasTarget(); });
+    Bench(perf, "nt GetRobotPose", iterations, [&](int) { g_sink = nt_vision.GetRobotPose().x; });
+    Bench(perf, "nt GetAllTargets", iterations,
+          [&](int) { g_sink = static_cast<double>(nt_vision.GetAllTargets().size()); });
+
+    // Simulated cameras: a wall of tags in front of the robot
+    auto sim = std::make_shared<xnav::SimTransport>();
+    std::vector<xnav::SimFieldTag> tags;
+    for (int i = 0; i < 22; ++i) {
+        tags.push_back({i + 1, 3.0, (i % 11) * 0.4 - 2.0, 0.5 + (i / 11) * 0.6, 1, 0, 0, 0});
+    }
+    sim->SetFieldLayout(tags);
+    xnav::SimCameraConfig cam;
+    cam.fps = 100.0;
+    for (int i = 0; i < 4; ++i) sim->AddCamera(cam);
+
+    xnav::RobotPose pose;
+    pose.valid = true;
+    Bench(perf, "sim Update (4 cams, 20ms)", iterations / 100, [&](int i) {
+        pose.x = 0.001 * (i % 1000);
+        g_sink = sim->Update(i * 0.02, pose);
+    });
+
+    xnav::XNav sim_vision;
+    sim_vision.UseSimTransport(sim);
+    Bench(perf, "sim HasTarget", iterations, [&](int) { g_sink = sim_vision.HasTarget(); });
+    Bench(perf, "sim GetPrimaryTarget", iterations,
+          [&](int) { g_sink = sim_vision.GetPrimaryTarget().distance; });
+    Bench(perf, "sim GetAllTargets", iterations,
+          [&](int) { g_sink = static_cast<double>(sim_vision.GetAllTargets().size()); });
+    Bench(perf, "sim GetRobotPose", iterations, [&](int) { g_sink = sim_vision.GetRobotPose().x; });
+    return 0;
+}
@@ -64,6 +64,10 @@ fi
 if ! grep -q "disable_camera_led=1" /boot/config.txt 2>/dev/null; then
   echo "disable_camera_led=1" >> /boot/config.txt
 fi
+# Hardware PWM on the LED pin (GPIO 18, ALT5) for lights.backend = hardware_pwm
+if ! grep -q "^dtoverlay=pwm" /boot/config.txt 2>/dev/null; then
+  echo "dtoverlay=pwm,pin=18,func=2" >> /boot/config.txt
+fi
 
 # ── Performance tweaks ───────────────────────────────────────────────────────
 log "Applying performance configuration..."
@@ -120,6 +124,16 @@ else
 fi
 deactivate
 
+# ── Native kernels (optional; Python fallbacks are used without them) ────────
+log "Building native vision library..."
+if apt-get install -y -qq cmake g++ pkg-config libapriltag-dev 2>&1 | tail -2 \
+   && cmake -S "$XNAV_DIR/vision_core/native" -B "$XNAV_DIR/vision_core/native/build" -DCMAKE_BUILD_TYPE=Release >/dev/null \
+   && cmake --build "$XNAV_DIR/vision_core/native/build" -j"$(nproc)" >/dev/null; then
+    log "Native library built"
+else
+    log "Native library not built; using Python fallbacks"
+fi
+
 # Update service scripts to use venv (only the installed copies)
 log "Installing systemd services..."
 cp "$REPO_ROOT/system/services/xnav-vision.service" /etc/systemd/system/
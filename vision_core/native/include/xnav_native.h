@@ -0,0 +1,114 @@
+#pragma once
+/**
+ * xnav_native.h - Native kernels for the XNav vision pipeline.
+ *
+ * A plain C ABI so the Python pipeline can load the library with ctypes
+ * (vision_core/src/native.py) and pass numpy buffers by pointer, with no
+ * binding generator or extra Python dependency.
+ *
+ * All functions are safe to call from any thread for distinct handles; a
+ * single handle must not be used from two threads at once.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** ABI version; bump on any signature or struct change. */
+#define XNAV_NATIVE_ABI 3
+
+int xnav_native_abi(void);
+
+/** Non-zero if built against the AprilTag C library. */
+int xnav_native_has_apriltag(void);
+
+// ─────────────────────────────────────────────────────────────────────────────
+// AprilTag detection
+// ─────────────────────────────────────────────────────────────────────────────
+
+typedef struct xnav_tag_detector xnav_tag_detector;
+
+/**
+ * Detection results as flat arrays (struct-of-arrays), owned by the detector
+ * and valid until its next detect call. Arrays grow as needed and are reused.
+ */
+typedef struct {
+    int32_t  count;
+    int32_t* ids;
+    int32_t* hamming;
+    float*   margin;
+    double*  centers;    /**< count x 2 (x, y), pixels */
+    double*  corners;    /**< count x 4 x 2, the library's corner order */
+} xnav_tag_batch;
+
+/**
+ * Create a detector. Returns NULL if the family is unknown or the library
+ * was built without the AprilTag C library.
+ */
+xnav_tag_detector* xnav_tag_detector_create(const char* family, int nthreads,
+                                            float quad_decimate, float quad_sigma,
+                                            int refine_edges, float decode_sharpening);
+
+/** Update the tunables of an existing detector (family and state are kept). */
+void xnav_tag_detector_configure(xnav_tag_detector* det, int nthreads, float quad_decimate,
+                                 float quad_sigma, int refine_edges, float decode_sharpening);
+
+/**
+ * Detect tags in an 8-bit gray image. The buffer is borrowed, not copied.
+ * With num_rois > 0, only the windows rois[4*i .. 4*i+3] = (x0, y0, x1, y1)
+ * are searched (in place, via the row stride) and results are shifted back
+ * to full-frame coordinates, keeping the best decision margin per id.
+ * Returns the number of detections, or -1 on error.
+ */
+int xnav_tag_detector_detect(xnav_tag_detector* det, const uint8_t* gray, int width,
+                             int height, int stride, const int32_t* rois, int num_rois);
+
+/** Results of the last detect call. */
+const xnav_tag_batch* xnav_tag_detector_batch(const xnav_tag_detector* det);
+
+void xnav_tag_detector_destroy(xnav_tag_detector* det);
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Tag pose
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * Closed-form planar pose (IPPE) of n square tags of side tag_size (meters).
+ * corners: n x 4 x 2 undistorted pixel corners, matching the model points
+ * (-s, s), (s, s), (s, -s), (-s, -s) with s = tag_size / 2.
+ * Outputs both candidate poses per tag, lower reprojection error first:
+ * R: n x 2 x 3 x 3 (row-major), t: n x 2 x 3, err: n x 2 (RMS pixels).
+ * num_solutions[i] is 2, or 0 for a degenerate quad (outputs untouched).
+ * Returns the number of tags solved, or -1 on bad arguments.
+ */
+int xnav_solve_square_poses(const double* corners, int n, double fx, double fy, double cx,
+                            double cy, double tag_size, double* R, double* t, double* err,
+                            int32_t* num_solutions);
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Preprocessing
+// ─────────────────────────────────────────────────────────────────────────────
+
+/** Kernel set chosen at load time: "avx2", "sse2", "neon" or "scalar". */
+const char* xnav_simd_name(void);
+
+/**
+ * 2x2 box decimation (rounded mean) into dst of (width / 2) x (height / 2).
+ * Returns 0, or -1 on bad arguments.
+ */
+int xnav_decimate2(const uint8_t* src, int width, int height, int src_stride, uint8_t* dst,
+                   int dst_stride);
+
+/**
+ * Gaussian blur by repeated 5-tap binomial passes ([1 4 6 4 1] / 16 in x
+ * and y, edges replicated), round(sigma^2) passes (at least one for
+ * sigma > 0). dst may equal src. Returns the number of passes, or -1.
+ */
+int xnav_gaussian_blur(const uint8_t* src, int width, int height, int src_stride, uint8_t* dst,
+                       int dst_stride, float sigma);
+
+#ifdef __cplusplus
+}
+#endif
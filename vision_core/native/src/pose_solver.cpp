@@ -0,0 +1,228 @@
+/**
+ * pose_solver.cpp - Closed-form planar pose for square tags (IPPE).
+ *
+ * Infinitesimal Plane-based Pose Estimation (Collins & Bartoli, 2014): the
+ * homography from the tag plane to normalized image coordinates, taken at
+ * the tag center, has a first-order (Jacobian) term that fixes the rotation
+ * up to a two-fold ambiguity. Both rotations are recovered in closed form,
+ * each translation by linear least squares, and each solution is scored by
+ * its RMS reprojection error in pixels. No iteration, no allocation.
+ *
+ * Conventions match cv2.solvePnPGeneric(SOLVEPNP_IPPE_SQUARE): model points
+ * (-s, s, 0), (s, s, 0), (s, -s, 0), (-s, -s, 0), errors as RMS over both
+ * coordinates of the four corners.
+ */
+
+#include "xnav_native.h"
+
+#include <cmath>
+#include <utility>
+
+namespace {
+
+constexpr double kEps = 1e-12;
+
+struct Mat3 {
+    double m[3][3];
+};
+
+/** Homography mapping the unit square (0,0),(1,0),(1,1),(0,1) to quad q. */
+bool SquareToQuad(const double q[4][2], Mat3& H) {
+    const double x0 = q[0][0], y0 = q[0][1], x1 = q[1][0], y1 = q[1][1];
+    const double x2 = q[2][0], y2 = q[2][1], x3 = q[3][0], y3 = q[3][1];
+    const double dx1 = x1 - x2, dx2 = x3 - x2, dx3 = x0 - x1 + x2 - x3;
+    const double dy1 = y1 - y2, dy2 = y3 - y2, dy3 = y0 - y1 + y2 - y3;
+    double g = 0.0, h = 0.0;
+    if (std::fabs(dx3) > kEps || std::fabs(dy3) > kEps) {
+        const double den = dx1 * dy2 - dx2 * dy1;
+        if (std::fabs(den) < kEps) return false;
+        g = (dx3 * dy2 - dx2 * dy3) / den;
+        h = (dx1 * dy3 - dx3 * dy1) / den;
+    }
+    H = {{{x1 - x0 + g * x1, x3 - x0 + h * x3, x0},
+          {y1 - y0 + g * y1, y3 - y0 + h * y3, y0},
+          {g, h, 1.0}}};
+    return true;
+}
+
+/** Rotation taking the direction of (p, q, 1) onto the optical axis. */
+Mat3 RotateToZ(double p, double q) {
+    const double n = std::sqrt(p * p + q * q + 1.0);
+    const double ax = p / n, ay = q / n, az = 1.0 / n;
+    const double d = 1.0 / (1.0 + az);
+    return {{{1.0 - ax * ax * d, -ax * ay * d, -ax},
+             {-ax * ay * d, 1.0 - ay * ay * d, -ay},
+             {ax, ay, 1.0 - (ax * ax + ay * ay) * d}}};
+}
+
+/**
+ * The two rotations consistent with Jacobian J of the plane-to-image map
+ * at the image point (p, q) of the tag center.
+ */
+bool IppeRotations(const double J[2][2], double p, double q, Mat3& Ra, Mat3& Rb) {
+    const Mat3 Rz = RotateToZ(p, q);
+    // Rv = Rz^T: maps the optical axis onto the viewing ray of (p, q)
+    double rv[3][3];
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) rv[r][c] = Rz.m[c][r];
+    }
+
+    const double b00 = rv[0][0] - p * rv[2][0], b01 = rv[0][1] - p * rv[2][1];
+    const double b10 = rv[1][0] - q * rv[2][0], b11 = rv[1][1] - q * rv[2][1];
+    const double det = b00 * b11 - b01 * b10;
+    if (std::fabs(det) < kEps) return false;
+    const double i00 = b11 / det, i01 = -b01 / det, i10 = -b10 / det, i11 = b00 / det;
+
+    const double a00 = i00 * J[0][0] + i01 * J[1][0];
+    const double a01 = i00 * J[0][1] + i01 * J[1][1];
+    const double a10 = i10 * J[0][0] + i11 * J[1][0];
+    const double a11 = i10 * J[0][1] + i11 * J[1][1];
+
+    // Largest singular value of A: the scale of the (weak-perspective) view
+    const double s00 = a00 * a00 + a01 * a01;
+    const double s01 = a00 * a10 + a01 * a11;
+    const double s11 = a10 * a10 + a11 * a11;
+    const double gamma2 = 0.5 * (s00 + s11 + std::sqrt((s00 - s11) * (s00 - s11) + 4.0 * s01 * s01));
+    if (gamma2 < kEps) return false;
+    const double gamma = std::sqrt(gamma2);
+
+    const double r00 = a00 / gamma, r01 = a01 / gamma, r10 = a10 / gamma, r11 = a11 / gamma;
+    const double c0 = std::sqrt(std::fmax(0.0, 1.0 - r00 * r00 - r10 * r10));
+    double c1 = std::sqrt(std::fmax(0.0, 1.0 - r01 * r01 - r11 * r11));
+    if (-r00 * r01 - r10 * r11 < 0.0) c1 = -c1;
+
+    // The two solutions differ in the sign of the out-of-plane components
+    for (int k = 0; k < 2; ++k) {
+        const double b0 = k == 0 ? c0 : -c0;
+        const double b1 = k == 0 ? c1 : -c1;
+        // Local rotation [[r00, r01, x], [r10, r11, y], [b0, b1, z]], third
+        // column the cross product of the first two
+        const double col2[3] = {r10 * b1 - b0 * r11, b0 * r01 - r00 * b1, r00 * r11 - r01 * r10};
+        Mat3& R = k == 0 ? Ra : Rb;
+        for (int r = 0; r < 3; ++r) {
+            R.m[r][0] = rv[r][0] * r00 + rv[r][1] * r10 + rv[r][2] * b0;
+            R.m[r][1] = rv[r][0] * r01 + rv[r][1] * r11 + rv[r][2] * b1;
+            R.m[r][2] = rv[r][0] * col2[0] + rv[r][1] * col2[1] + rv[r][2] * col2[2];
+        }
+    }
+    return true;
+}
+
+/** Least-squares translation for rotation R (normalized image coordinates). */
+bool SolveTranslation(const Mat3& R, const double model[4][2], const double uv[4][2],
+                      double t[3]) {
+    // Each point: tx - u tz = u (r3.X) - r1.X,  ty - v tz = v (r3.X) - r2.X
+    double A[3][3] = {}, b[3] = {};
+    for (int i = 0; i < 4; ++i) {
+        const double X = model[i][0], Y = model[i][1];
+        const double px = R.m[0][0] * X + R.m[0][1] * Y;
+        const double py = R.m[1][0] * X + R.m[1][1] * Y;
+        const double pz = R.m[2][0] * X + R.m[2][1] * Y;
+        const double u = uv[i][0], v = uv[i][1];
+        const double rows[2][4] = {{1.0, 0.0, -u, u * pz - px}, {0.0, 1.0, -v, v * pz - py}};
+        for (const auto& row : rows) {
+            for (int r = 0; r < 3; ++r) {
+                for (int c = 0; c < 3; ++c) A[r][c] += row[r] * row[c];
+                b[r] += row[r] * row[3];
+            }
+        }
+    }
+    const double det = A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1])
+                     - A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0])
+                     + A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0]);
+    if (std::fabs(det) < kEps) return false;
+    // Cramer's rule
+    for (int k = 0; k < 3; ++k) {
+        double M[3][3];
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) M[r][c] = c == k ? b[r] : A[r][c];
+        }
+        t[k] = (M[0][0] * (M[1][1] * M[2][2] - M[1][2] * M[2][1])
+              - M[0][1] * (M[1][0] * M[2][2] - M[1][2] * M[2][0])
+              + M[0][2] * (M[1][0] * M[2][1] - M[1][1] * M[2][0])) / det;
+    }
+    return true;
+}
+
+double ReprojectionRms(const Mat3& R, const double t[3], const double model[4][2],
+                       const double* px, double fx, double fy, double cx, double cy) {
+    double sum = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        const double X = model[i][0], Y = model[i][1];
+        const double x = R.m[0][0] * X + R.m[0][1] * Y + t[0];
+        const double y = R.m[1][0] * X + R.m[1][1] * Y + t[1];
+        const double z = R.m[2][0] * X + R.m[2][1] * Y + t[2];
+        if (std::fabs(z) < kEps) return HUGE_VAL;
+        const double du = fx * x / z + cx - px[i * 2];
+        const double dv = fy * y / z + cy - px[i * 2 + 1];
+        sum += du * du + dv * dv;
+    }
+    return std::sqrt(sum / 8.0);
+}
+
+bool SolveOne(const double* px, double fx, double fy, double cx, double cy, double s,
+              double* R_out, double* t_out, double* err_out) {
+    const double model[4][2] = {{-s, s}, {s, s}, {s, -s}, {-s, -s}};
+    double uv[4][2];
+    for (int i = 0; i < 4; ++i) {
+        uv[i][0] = (px[i * 2] - cx) / fx;
+        uv[i][1] = (px[i * 2 + 1] - cy) / fy;
+    }
+
+    // Plane-to-image homography: model -> unit square (affine) -> quad
+    Mat3 Hq;
+    if (!SquareToQuad(uv, Hq)) return false;
+    // (X, Y) -> ((X + s) / 2s, (s - Y) / 2s)
+    const double k = 0.5 / s;
+    double H[3][3];
+    for (int r = 0; r < 3; ++r) {
+        H[r][0] = Hq.m[r][0] * k;
+        H[r][1] = -Hq.m[r][1] * k;
+        H[r][2] = 0.5 * (Hq.m[r][0] + Hq.m[r][1]) + Hq.m[r][2];
+    }
+    if (std::fabs(H[2][2]) < kEps) return false;
+
+    // Image of the tag center and the Jacobian of the map there
+    const double p = H[0][2] / H[2][2], q = H[1][2] / H[2][2];
+    const double J[2][2] = {{(H[0][0] - H[2][0] * p) / H[2][2], (H[0][1] - H[2][1] * p) / H[2][2]},
+                            {(H[1][0] - H[2][0] * q) / H[2][2], (H[1][1] - H[2][1] * q) / H[2][2]}};
+
+    Mat3 Rs[2];
+    if (!IppeRotations(J, p, q, Rs[0], Rs[1])) return false;
+
+    double ts[2][3], errs[2];
+    for (int k2 = 0; k2 < 2; ++k2) {
+        if (!SolveTranslation(Rs[k2], model, uv, ts[k2])) return false;
+        errs[k2] = ReprojectionRms(Rs[k2], ts[k2], model, px, fx, fy, cx, cy);
+    }
+    const int first = errs[1] < errs[0] ? 1 : 0;
+    for (int k2 = 0; k2 < 2; ++k2) {
+        const int src = k2 == 0 ? first : 1 - first;
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) R_out[k2 * 9 + r * 3 + c] = Rs[src].m[r][c];
+            t_out[k2 * 3 + r] = ts[src][r];
+        }
+        err_out[k2] = errs[src];
+    }
+    return true;
+}
+
+} // namespace
+
+extern "C" {
+
+int xnav_solve_square_poses(const double* corners, int n, double fx, double fy, double cx,
+                            double cy, double tag_size, double* R, double* t, double* err,
+                            int32_t* num_solutions) {
+    if (corners == nullptr || n < 0 || fx <= 0.0 || fy <= 0.0 || tag_size <= 0.0) return -1;
+    int solved = 0;
+    for (int i = 0; i < n; ++i) {
+        const bool ok = SolveOne(corners + i * 8, fx, fy, cx, cy, tag_size / 2.0,
+                                 R + i * 18, t + i * 6, err + i * 2);
+        num_solutions[i] = ok ? 2 : 0;
+        solved += ok ? 1 : 0;
+    }
+    return solved;
+}
+
+} // extern "C"
@@ -0,0 +1,330 @@
+/**
+ * preprocess.cpp - Vectorized frame pre-pass kernels.
+ *
+ * 2x2 box decimation and a separable binomial Gaussian blur on 8-bit gray
+ * frames, so the detector can run on an image that is already decimated
+ * and smoothed instead of doing both with the AprilTag library's scalar
+ * code. Row kernels exist as scalar, SSE2, AVX2 (x86-64) and NEON (ARM)
+ * variants producing identical output; the best one the CPU supports is
+ * picked once at load time (XNAV_SIMD=scalar|sse2|avx2|neon overrides).
+ */
+
+#include "xnav_native.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define XNAV_X86 1
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#define XNAV_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Row kernels
+// ─────────────────────────────────────────────────────────────────────────────
+// decimate2: out[x] = (r0[2x] + r0[2x+1] + r1[2x] + r1[2x+1] + 2) >> 2
+// hblur:     out[x] = in[x-2] + 4 in[x-1] + 6 in[x] + 4 in[x+1] + in[x+2]
+//            for x in [2, width - 2); the caller fills the borders
+// vblur:     out[x] = (r0 + 4 r1 + 6 r2 + 4 r3 + r4 + 128) >> 8
+
+using Decimate2Fn = void (*)(const uint8_t* r0, const uint8_t* r1, uint8_t* out, int out_w);
+using HBlurFn = void (*)(const uint8_t* in, uint16_t* out, int width);
+using VBlurFn = void (*)(const uint16_t* const* rows, uint8_t* out, int width);
+
+void Decimate2Scalar(const uint8_t* r0, const uint8_t* r1, uint8_t* out, int out_w) {
+    for (int x = 0; x < out_w; ++x) {
+        out[x] = static_cast<uint8_t>((r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1] + 2) >> 2);
+    }
+}
+
+void HBlurScalar(const uint8_t* in, uint16_t* out, int width) {
+    for (int x = 2; x < width - 2; ++x) {
+        out[x] = static_cast<uint16_t>(in[x - 2] + 4 * in[x - 1] + 6 * in[x] + 4 * in[x + 1] + in[x + 2]);
+    }
+}
+
+inline uint8_t VBlurPixel(const uint16_t* const* r, int x) {
+    return static_cast<uint8_t>((r[0][x] + 4 * r[1][x] + 6 * r[2][x] + 4 * r[3][x] + r[4][x] + 128) >> 8);
+}
+
+void VBlurScalar(const uint16_t* const* rows, uint8_t* out, int width) {
+    for (int x = 0; x < width; ++x) out[x] = VBlurPixel(rows, x);
+}
+
+#ifdef XNAV_X86
+
+void Decimate2Sse2(const uint8_t* r0, const uint8_t* r1, uint8_t* out, int out_w) {
+    const __m128i lo = _mm_set1_epi16(0x00FF);
+    const __m128i two = _mm_set1_epi16(2);
+    int x = 0;
+    for (; x + 16 <= out_w; x += 16) {
+        __m128i sums[2];
+        for (int h = 0; h < 2; ++h) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + 2 * x + 16 * h));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + 2 * x + 16 * h));
+            const __m128i s = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a, lo), _mm_srli_epi16(a, 8)),
+                                            _mm_add_epi16(_mm_and_si128(b, lo), _mm_srli_epi16(b, 8)));
+            sums[h] = _mm_srli_epi16(_mm_add_epi16(s, two), 2);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(sums[0], sums[1]));
+    }
+    Decimate2Scalar(r0 + 2 * x, r1 + 2 * x, out + x, out_w - x);
+}
+
+void HBlurSse2(const uint8_t* in, uint16_t* out, int width) {
+    const __m128i zero = _mm_setzero_si128();
+    int x = 2;
+    for (; x + 8 + 2 <= width; x += 8) {
+        auto load = [&](int off) {
+            return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + x + off)), zero);
+        };
+        const __m128i c = load(0);
+        const __m128i n1 = _mm_add_epi16(load(-1), load(1));
+        const __m128i n2 = _mm_add_epi16(load(-2), load(2));
+        const __m128i s = _mm_add_epi16(_mm_add_epi16(n2, _mm_slli_epi16(n1, 2)),
+                                        _mm_add_epi16(_mm_slli_epi16(c, 2), _mm_slli_epi16(c, 1)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), s);
+    }
+    for (; x < width - 2; ++x) {
+        out[x] = static_cast<uint16_t>(in[x - 2] + 4 * in[x - 1] + 6 * in[x] + 4 * in[x + 1] + in[x + 2]);
+    }
+}
+
+void VBlurSse2(const uint16_t* const* r, uint8_t* out, int width) {
+    const __m128i round = _mm_set1_epi16(128);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        auto load = [&](int k) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(r[k] + x)); };
+        const __m128i c = load(2);
+        const __m128i n1 = _mm_add_epi16(load(1), load(3));
+        const __m128i n2 = _mm_add_epi16(load(0), load(4));
+        __m128i s = _mm_add_epi16(_mm_add_epi16(n2, _mm_slli_epi16(n1, 2)),
+                                  _mm_add_epi16(_mm_slli_epi16(c, 2), _mm_slli_epi16(c, 1)));
+        s = _mm_srli_epi16(_mm_add_epi16(s, round), 8);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(s, s));
+    }
+    for (; x < width; ++x) out[x] = VBlurPixel(r, x);
+}
+
+__attribute__((target("avx2")))
+void Decimate2Avx2(const uint8_t* r0, const uint8_t* r1, uint8_t* out, int out_w) {
+    const __m256i lo = _mm256_set1_epi16(0x00FF);
+    const __m256i two = _mm256_set1_epi16(2);
+    int x = 0;
+    for (; x + 32 <= out_w; x += 32) {
+        __m256i sums[2];
+        for (int h = 0; h < 2; ++h) {
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r0 + 2 * x + 32 * h));
+            const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r1 + 2 * x + 32 * h));
+            const __m256i s = _mm256_add_epi16(
+                _mm256_add_epi16(_mm256_and_si256(a, lo), _mm256_srli_epi16(a, 8)),
+                _mm256_add_epi16(_mm256_and_si256(b, lo), _mm256_srli_epi16(b, 8)));
+            sums[h] = _mm256_srli_epi16(_mm256_add_epi16(s, two), 2);
+        }
+        // packus works per 128-bit lane; restore the element order
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(sums[0], sums[1]), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), packed);
+    }
+    Decimate2Sse2(r0 + 2 * x, r1 + 2 * x, out + x, out_w - x);
+}
+
+__attribute__((target("avx2")))
+inline __m256i LoadU8x16(const uint8_t* p) {
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+__attribute__((target("avx2")))
+inline __m256i LoadU16x16(const uint16_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+__attribute__((target("avx2")))
+void HBlurAvx2(const uint8_t* in, uint16_t* out, int width) {
+    int x = 2;
+    for (; x + 16 + 2 <= width; x += 16) {
+        const __m256i c = LoadU8x16(in + x);
+        const __m256i n1 = _mm256_add_epi16(LoadU8x16(in + x - 1), LoadU8x16(in + x + 1));
+        const __m256i n2 = _mm256_add_epi16(LoadU8x16(in + x - 2), LoadU8x16(in + x + 2));
+        const __m256i s = _mm256_add_epi16(_mm256_add_epi16(n2, _mm256_slli_epi16(n1, 2)),
+                                           _mm256_add_epi16(_mm256_slli_epi16(c, 2), _mm256_slli_epi16(c, 1)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), s);
+    }
+    for (; x < width - 2; ++x) {
+        out[x] = static_cast<uint16_t>(in[x - 2] + 4 * in[x - 1] + 6 * in[x] + 4 * in[x + 1] + in[x + 2]);
+    }
+}
+
+__attribute__((target("avx2")))
+void VBlurAvx2(const uint16_t* const* r, uint8_t* out, int width) {
+    const __m256i round = _mm256_set1_epi16(128);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m256i c = LoadU16x16(r[2] + x);
+        const __m256i n1 = _mm256_add_epi16(LoadU16x16(r[1] + x), LoadU16x16(r[3] + x));
+        const __m256i n2 = _mm256_add_epi16(LoadU16x16(r[0] + x), LoadU16x16(r[4] + x));
+        __m256i s = _mm256_add_epi16(_mm256_add_epi16(n2, _mm256_slli_epi16(n1, 2)),
+                                     _mm256_add_epi16(_mm256_slli_epi16(c, 2), _mm256_slli_epi16(c, 1)));
+        s = _mm256_srli_epi16(_mm256_add_epi16(s, round), 8);
+        const __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), packed);
+    }
+    for (; x < width; ++x) out[x] = VBlurPixel(r, x);
+}
+
+#endif // XNAV_X86
+
+#ifdef XNAV_NEON
+
+void Decimate2Neon(const uint8_t* r0, const uint8_t* r1, uint8_t* out, int out_w) {
+    int x = 0;
+    for (; x + 16 <= out_w; x += 16) {
+        uint16x8_t a = vpaddlq_u8(vld1q_u8(r0 + 2 * x));
+        uint16x8_t b = vpaddlq_u8(vld1q_u8(r0 + 2 * x + 16));
+        a = vpadalq_u8(a, vld1q_u8(r1 + 2 * x));
+        b = vpadalq_u8(b, vld1q_u8(r1 + 2 * x + 16));
+        vst1q_u8(out + x, vcombine_u8(vrshrn_n_u16(a, 2), vrshrn_n_u16(b, 2)));
+    }
+    Decimate2Scalar(r0 + 2 * x, r1 + 2 * x, out + x, out_w - x);
+}
+
+void HBlurNeon(const uint8_t* in, uint16_t* out, int width) {
+    int x = 2;
+    for (; x + 8 + 2 <= width; x += 8) {
+        const uint16x8_t c = vmovl_u8(vld1_u8(in + x));
+        const uint16x8_t n1 = vaddl_u8(vld1_u8(in + x - 1), vld1_u8(in + x + 1));
+        const uint16x8_t n2 = vaddl_u8(vld1_u8(in + x - 2), vld1_u8(in + x + 2));
+        uint16x8_t s = vmlaq_n_u16(n2, n1, 4);
+        s = vmlaq_n_u16(s, c, 6);
+        vst1q_u16(out + x, s);
+    }
+    for (; x < width - 2; ++x) {
+        out[x] = static_cast<uint16_t>(in[x - 2] + 4 * in[x - 1] + 6 * in[x] + 4 * in[x + 1] + in[x + 2]);
+    }
+}
+
+void VBlurNeon(const uint16_t* const* r, uint8_t* out, int width) {
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        uint16x8_t s = vaddq_u16(vld1q_u16(r[0] + x), vld1q_u16(r[4] + x));
+        s = vmlaq_n_u16(s, vaddq_u16(vld1q_u16(r[1] + x), vld1q_u16(r[3] + x)), 4);
+        s = vmlaq_n_u16(s, vld1q_u16(r[2] + x), 6);
+        // (s + 128) >> 8 without overflowing 16 bits
+        vst1_u8(out + x, vrshrn_n_u16(s, 8));
+    }
+    for (; x < width; ++x) out[x] = VBlurPixel(r, x);
+}
+
+#endif // XNAV_NEON
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Dispatch
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct Kernels {
+    const char* name;
+    Decimate2Fn decimate2;
+    HBlurFn hblur;
+    VBlurFn vblur;
+};
+
+const Kernels kScalar = {"scalar", Decimate2Scalar, HBlurScalar, VBlurScalar};
+
+Kernels Select() {
+    const char* env = std::getenv("XNAV_SIMD");
+    const std::string want = env != nullptr ? env : "";
+    if (want == "scalar") return kScalar;
+#ifdef XNAV_X86
+    __builtin_cpu_init();
+    if (want != "sse2" && __builtin_cpu_supports("avx2")) {
+        return {"avx2", Decimate2Avx2, HBlurAvx2, VBlurAvx2};
+    }
+    return {"sse2", Decimate2Sse2, HBlurSse2, VBlurSse2};
+#elif defined(XNAV_NEON)
+    return {"neon", Decimate2Neon, HBlurNeon, VBlurNeon};
+#else
+    return kScalar;
+#endif
+}
+
+const Kernels& Active() {
+    static const Kernels k = Select();
+    return k;
+}
+
+/** One horizontal blur row, borders replicated. */
+void HBlurRow(const Kernels& k, const uint8_t* in, uint16_t* out, int w) {
+    k.hblur(in, out, w);
+    auto at = [&](int i) { return in[i < 0 ? 0 : i >= w ? w - 1 : i]; };
+    auto border = [&](int x) {
+        out[x] = static_cast<uint16_t>(at(x - 2) + 4 * at(x - 1) + 6 * at(x) + 4 * at(x + 1) + at(x + 2));
+    };
+    const int edge = std::min(2, w);
+    for (int x = 0; x < edge; ++x) border(x);
+    for (int x = std::max(edge, w - 2); x < w; ++x) border(x);
+}
+
+} // namespace
+
+extern "C" {
+
+const char* xnav_simd_name(void) { return Active().name; }
+
+int xnav_decimate2(const uint8_t* src, int width, int height, int src_stride, uint8_t* dst,
+                   int dst_stride) {
+    if (src == nullptr || dst == nullptr || width < 2 || height < 2) return -1;
+    const Kernels& k = Active();
+    const int ow = width / 2, oh = height / 2;
+    for (int y = 0; y < oh; ++y) {
+        const uint8_t* r0 = src + static_cast<size_t>(2 * y) * src_stride;
+        k.decimate2(r0, r0 + src_stride, dst + static_cast<size_t>(y) * dst_stride, ow);
+    }
+    return 0;
+}
+
+int xnav_gaussian_blur(const uint8_t* src, int width, int height, int src_stride, uint8_t* dst,
+                       int dst_stride, float sigma) {
+    if (src == nullptr || dst == nullptr || width < 1 || height < 1) return -1;
+    const Kernels& k = Active();
+    // Each pass of the 5-tap binomial adds a variance of 1 px^2
+    const int passes = sigma > 0.0f ? std::max(1, static_cast<int>(std::lround(sigma * sigma))) : 0;
+    if (passes == 0) {
+        for (int y = 0; y < height; ++y) {
+            std::memmove(dst + static_cast<size_t>(y) * dst_stride,
+                         src + static_cast<size_t>(y) * src_stride, width);
+        }
+        return 0;
+    }
+
+    // Ring of five horizontally filtered rows; dst row y is written once
+    // rows up to y + 2 are filtered, so passes after the first run in place
+    thread_local std::vector<uint16_t> ring;
+    ring.resize(static_cast<size_t>(width) * 5);
+    for (int p = 0; p < passes; ++p) {
+        const uint8_t* in = p == 0 ? src : dst;
+        const int in_stride = p == 0 ? src_stride : dst_stride;
+        auto row = [&](int y) {
+            y = y < 0 ? 0 : y >= height ? height - 1 : y;
+            return in + static_cast<size_t>(y) * in_stride;
+        };
+        auto slot = [&](int y) { return ring.data() + static_cast<size_t>((y + 10) % 5) * width; };
+        for (int y = -2; y < 2; ++y) HBlurRow(k, row(y), slot(y), width);
+        for (int y = 0; y < height; ++y) {
+            HBlurRow(k, row(y + 2), slot(y + 2), width);
+            const uint16_t* rows[5] = {slot(y - 2), slot(y - 1), slot(y), slot(y + 1), slot(y + 2)};
+            k.vblur(rows, dst + static_cast<size_t>(y) * dst_stride, width);
+        }
+    }
+    return passes;
+}
+
+} // extern "C"
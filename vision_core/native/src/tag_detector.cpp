@@ -0,0 +1,204 @@
+/**
+ * tag_detector.cpp - AprilTag detection over borrowed frame buffers.
+ *
+ * Wraps the AprilTag C library so a frame goes from the frame pool to the
+ * detector without a copy: the image_u8 header points at the caller's
+ * buffer (ROIs are windows into it via the row stride), the detector and
+ * family stay alive across frames, and results land in flat arrays reused
+ * from frame to frame instead of one Python object per detection.
+ */
+
+#include "xnav_native.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef XNAV_HAVE_APRILTAG
+#include <apriltag/apriltag.h>
+#include <apriltag/tag16h5.h>
+#include <apriltag/tag25h9.h>
+#include <apriltag/tag36h11.h>
+#include <apriltag/tagCircle21h7.h>
+#include <apriltag/tagStandard41h12.h>
+#endif
+
+#ifdef XNAV_HAVE_APRILTAG
+
+namespace {
+
+struct Family {
+    const char* name;
+    apriltag_family_t* (*create)();
+    void (*destroy)(apriltag_family_t*);
+};
+
+const Family kFamilies[] = {
+    {"tag36h11", tag36h11_create, tag36h11_destroy},
+    {"tag25h9", tag25h9_create, tag25h9_destroy},
+    {"tag16h5", tag16h5_create, tag16h5_destroy},
+    {"tagCircle21h7", tagCircle21h7_create, tagCircle21h7_destroy},
+    {"tagStandard41h12", tagStandard41h12_create, tagStandard41h12_destroy},
+};
+
+} // namespace
+
+struct xnav_tag_detector {
+    apriltag_detector_t* td = nullptr;
+    apriltag_family_t* family = nullptr;
+    const Family* family_def = nullptr;
+
+    // Result storage (grows, never shrinks)
+    std::vector<int32_t> ids, hamming;
+    std::vector<float> margin;
+    std::vector<double> centers, corners;
+    xnav_tag_batch batch{};
+
+    void Reserve(size_t n) {
+        if (ids.size() >= n) return;
+        n = n < 16 ? 16 : n * 2;
+        ids.resize(n);
+        hamming.resize(n);
+        margin.resize(n);
+        centers.resize(n * 2);
+        corners.resize(n * 8);
+        batch.ids = ids.data();
+        batch.hamming = hamming.data();
+        batch.margin = margin.data();
+        batch.centers = centers.data();
+        batch.corners = corners.data();
+    }
+
+    /** Append (or, with dedup, replace a weaker same-id row) one detection. */
+    void Add(const apriltag_detection_t* d, double dx, double dy, bool dedup) {
+        int row = batch.count;
+        if (dedup) {
+            for (int i = 0; i < batch.count; ++i) {
+                if (ids[i] != d->id) continue;
+                if (d->decision_margin <= margin[i]) return;
+                row = i;
+                break;
+            }
+        }
+        if (row == batch.count) {
+            Reserve(static_cast<size_t>(row) + 1);
+            ++batch.count;
+        }
+        ids[row] = d->id;
+        hamming[row] = d->hamming;
+        margin[row] = d->decision_margin;
+        centers[row * 2] = d->c[0] + dx;
+        centers[row * 2 + 1] = d->c[1] + dy;
+        for (int k = 0; k < 4; ++k) {
+            corners[row * 8 + k * 2] = d->p[k][0] + dx;
+            corners[row * 8 + k * 2 + 1] = d->p[k][1] + dy;
+        }
+    }
+
+    /** Detect in one window of the frame; returns false on library error. */
+    bool DetectWindow(const uint8_t* gray, int stride, int x0, int y0, int x1, int y1,
+                      bool dedup) {
+        image_u8_t im{x1 - x0, y1 - y0, stride,
+                      const_cast<uint8_t*>(gray + static_cast<size_t>(y0) * stride + x0)};
+        zarray_t* dets = apriltag_detector_detect(td, &im);
+        if (dets == nullptr) return false;
+        const int n = zarray_size(dets);
+        Reserve(static_cast<size_t>(batch.count + n));
+        for (int i = 0; i < n; ++i) {
+            apriltag_detection_t* d = nullptr;
+            zarray_get(dets, i, &d);
+            Add(d, x0, y0, dedup);
+        }
+        apriltag_detections_destroy(dets);
+        return true;
+    }
+};
+
+extern "C" {
+
+xnav_tag_detector* xnav_tag_detector_create(const char* family, int nthreads,
+                                            float quad_decimate, float quad_sigma,
+                                            int refine_edges, float decode_sharpening) {
+    const Family* def = nullptr;
+    for (const auto& f : kFamilies) {
+        if (family != nullptr && std::strcmp(f.name, family) == 0) def = &f;
+    }
+    if (def == nullptr) return nullptr;
+
+    auto* det = new xnav_tag_detector;
+    det->family_def = def;
+    det->family = def->create();
+    det->td = apriltag_detector_create();
+    apriltag_detector_add_family(det->td, det->family);
+    xnav_tag_detector_configure(det, nthreads, quad_decimate, quad_sigma, refine_edges,
+                                decode_sharpening);
+    det->Reserve(16);
+    return det;
+}
+
+void xnav_tag_detector_configure(xnav_tag_detector* det, int nthreads, float quad_decimate,
+                                 float quad_sigma, int refine_edges, float decode_sharpening) {
+    if (det == nullptr) return;
+    det->td->nthreads = nthreads > 0 ? nthreads : 1;
+    det->td->quad_decimate = quad_decimate >= 1.0f ? quad_decimate : 1.0f;
+    det->td->quad_sigma = quad_sigma;
+    det->td->refine_edges = refine_edges != 0;
+    det->td->decode_sharpening = decode_sharpening;
+    det->td->debug = false;
+}
+
+int xnav_tag_detector_detect(xnav_tag_detector* det, const uint8_t* gray, int width,
+                             int height, int stride, const int32_t* rois, int num_rois) {
+    if (det == nullptr || gray == nullptr || width <= 0 || height <= 0 || stride < width) {
+        return -1;
+    }
+    det->batch.count = 0;
+    if (num_rois <= 0) {
+        return det->DetectWindow(gray, stride, 0, 0, width, height, false) ? det->batch.count : -1;
+    }
+    for (int i = 0; i < num_rois; ++i) {
+        const int x0 = rois[i * 4] < 0 ? 0 : rois[i * 4];
+        const int y0 = rois[i * 4 + 1] < 0 ? 0 : rois[i * 4 + 1];
+        const int x1 = rois[i * 4 + 2] > width ? width : rois[i * 4 + 2];
+        const int y1 = rois[i * 4 + 3] > height ? height : rois[i * 4 + 3];
+        if (x1 - x0 < 8 || y1 - y0 < 8) continue;
+        if (!det->DetectWindow(gray, stride, x0, y0, x1, y1, true)) return -1;
+    }
+    return det->batch.count;
+}
+
+const xnav_tag_batch* xnav_tag_detector_batch(const xnav_tag_detector* det) {
+    return det != nullptr ? &det->batch : nullptr;
+}
+
+void xnav_tag_detector_destroy(xnav_tag_detector* det) {
+    if (det == nullptr) return;
+    apriltag_detector_destroy(det->td);
+    det->family_def->destroy(det->family);
+    delete det;
+}
+
+} // extern "C"
+
+#else  // !XNAV_HAVE_APRILTAG
+
+extern "C" {
+
+xnav_tag_detector* xnav_tag_detector_create(const char*, int, float, float, int, float) {
+    return nullptr;
+}
+
+void xnav_tag_detector_configure(xnav_tag_detector*, int, float, float, int, float) {}
+
+int xnav_tag_detector_detect(xnav_tag_detector*, const uint8_t*, int, int, int,
+                             const int32_t*, int) {
+    return -1;
+}
+
+const xnav_tag_batch* xnav_tag_detector_batch(const xnav_tag_detector*) { return nullptr; }
+
+void xnav_tag_detector_destroy(xnav_tag_detector*) {}
+
+} // extern "C"
+
+#endif // XNAV_HAVE_APRILTAG
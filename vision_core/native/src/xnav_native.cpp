@@ -0,0 +1,19 @@
+/**
+ * xnav_native.cpp - Library-wide entry points (ABI version, build features).
+ */
+
+#include "xnav_native.h"
+
+extern "C" {
+
+int xnav_native_abi(void) { return XNAV_NATIVE_ABI; }
+
+int xnav_native_has_apriltag(void) {
+#ifdef XNAV_HAVE_APRILTAG
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+} // extern "C"
@@ -0,0 +1,240 @@
+/**
+ * test_preprocess.cpp - Pre-pass kernels against a scalar reference.
+ *
+ * Run once per kernel set (CTest sets XNAV_SIMD); argv[1] names the set
+ * the run expects. When the CPU cannot run it the library falls back to
+ * another set and the test reports a skip. Every set is checked for
+ * bit-exact output against the per-pixel definitions below, which the
+ * "scalar" run pins to the library's scalar path.
+ */
+
+#include "xnav_native.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int kSkip = 77;
+constexpr uint8_t kGuard = 0xA5;
+
+int g_failures = 0;
+
+#define CHECK(cond, ...)                                                     \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            std::fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__);        \
+            std::fprintf(stderr, __VA_ARGS__);                               \
+            std::fprintf(stderr, "\n");                                      \
+            ++g_failures;                                                    \
+        }                                                                    \
+    } while (0)
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Reference
+// ─────────────────────────────────────────────────────────────────────────────
+
+/** Gray image view with its own storage; the padding after each row is a guard. */
+struct Image {
+    int width = 0, height = 0, stride = 0;
+    std::vector<uint8_t> data;
+
+    Image(int w, int h, int pad) : width(w), height(h), stride(w + pad) {
+        data.assign(static_cast<size_t>(stride) * h, kGuard);
+    }
+    uint8_t& at(int x, int y) { return data[static_cast<size_t>(y) * stride + x]; }
+    uint8_t at(int x, int y) const { return data[static_cast<size_t>(y) * stride + x]; }
+    uint8_t clamped(int x, int y) const {
+        x = x < 0 ? 0 : x >= width ? width - 1 : x;
+        y = y < 0 ? 0 : y >= height ? height - 1 : y;
+        return at(x, y);
+    }
+};
+
+Image Random(int w, int h, int pad, std::mt19937& rng) {
+    Image img(w, h, pad);
+    std::uniform_int_distribution<int> dist(0, 255);
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x) img.at(x, y) = static_cast<uint8_t>(dist(rng));
+    return img;
+}
+
+Image RefDecimate2(const Image& src) {
+    Image out(src.width / 2, src.height / 2, 0);
+    for (int y = 0; y < out.height; ++y)
+        for (int x = 0; x < out.width; ++x)
+            out.at(x, y) = static_cast<uint8_t>((src.at(2 * x, 2 * y) + src.at(2 * x + 1, 2 * y) +
+                                                 src.at(2 * x, 2 * y + 1) +
+                                                 src.at(2 * x + 1, 2 * y + 1) + 2) >> 2);
+    return out;
+}
+
+Image RefBlurPass(const Image& src) {
+    static const int taps[5] = {1, 4, 6, 4, 1};
+    const int w = src.width, h = src.height;
+    std::vector<int> rows(static_cast<size_t>(w) * h);
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x) {
+            int s = 0;
+            for (int k = 0; k < 5; ++k) s += taps[k] * src.clamped(x + k - 2, y);
+            rows[static_cast<size_t>(y) * w + x] = s;
+        }
+    Image out(w, h, 0);
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x) {
+            int s = 0;
+            for (int k = 0; k < 5; ++k) {
+                const int yy = std::min(std::max(y + k - 2, 0), h - 1);
+                s += taps[k] * rows[static_cast<size_t>(yy) * w + x];
+            }
+            out.at(x, y) = static_cast<uint8_t>((s + 128) >> 8);
+        }
+    return out;
+}
+
+int RefPasses(float sigma) {
+    return sigma > 0.0f ? std::max(1, static_cast<int>(std::lround(sigma * sigma))) : 0;
+}
+
+Image RefBlur(Image img, float sigma) {
+    Image out(img.width, img.height, 0);
+    for (int y = 0; y < img.height; ++y)
+        for (int x = 0; x < img.width; ++x) out.at(x, y) = img.at(x, y);
+    for (int p = 0; p < RefPasses(sigma); ++p) out = RefBlurPass(out);
+    return out;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Comparison
+// ─────────────────────────────────────────────────────────────────────────────
+
+/** Pixels match the reference and the row padding is untouched. */
+bool Matches(const Image& got, const Image& want, const char* what, float sigma) {
+    for (int y = 0; y < want.height; ++y) {
+        for (int x = 0; x < want.width; ++x) {
+            if (got.at(x, y) != want.at(x, y)) {
+                CHECK(false, "%s %dx%d sigma %.2f: (%d, %d) = %d, want %d", what, want.width,
+                      want.height, sigma, x, y, got.at(x, y), want.at(x, y));
+                return false;
+            }
+        }
+        for (int x = want.width; x < got.stride; ++x) {
+            if (got.at(x, y) != kGuard) {
+                CHECK(false, "%s %dx%d: padding written at (%d, %d)", what, want.width,
+                      want.height, x, y);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void TestDecimate(int w, int h, int src_pad, int dst_pad, std::mt19937& rng) {
+    const Image src = Random(w, h, src_pad, rng);
+    Image dst(w / 2, h / 2, dst_pad);
+    const int rc = xnav_decimate2(src.data.data(), w, h, src.stride, dst.data.data(), dst.stride);
+    CHECK(rc == 0, "decimate2 %dx%d returned %d", w, h, rc);
+    Matches(dst, RefDecimate2(src), "decimate2", 0.0f);
+}
+
+void TestBlur(int w, int h, int src_pad, int dst_pad, float sigma, std::mt19937& rng) {
+    const Image src = Random(w, h, src_pad, rng);
+    const Image want = RefBlur(src, sigma);
+
+    Image dst(w, h, dst_pad);
+    int rc = xnav_gaussian_blur(src.data.data(), w, h, src.stride, dst.data.data(), dst.stride,
+                                sigma);
+    CHECK(rc == RefPasses(sigma), "blur %dx%d sigma %.2f returned %d", w, h, sigma, rc);
+    Matches(dst, want, "blur", sigma);
+
+    Image inplace = src;
+    rc = xnav_gaussian_blur(inplace.data.data(), w, h, inplace.stride, inplace.data.data(),
+                            inplace.stride, sigma);
+    CHECK(rc == RefPasses(sigma), "in-place blur %dx%d sigma %.2f returned %d", w, h, sigma, rc);
+    Matches(inplace, want, "in-place blur", sigma);
+}
+
+/** A window inside a larger frame: the stride is the parent's width. */
+void TestSubView(std::mt19937& rng) {
+    const Image parent = Random(97, 41, 3, rng);
+    const int ox = 5, oy = 3, w = 67, h = 29;
+    Image view(w, h, parent.stride - w);
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x) view.at(x, y) = parent.at(ox + x, oy + y);
+    const uint8_t* origin = parent.data.data() + static_cast<size_t>(oy) * parent.stride + ox;
+
+    Image dec(w / 2, h / 2, 7);
+    CHECK(xnav_decimate2(origin, w, h, parent.stride, dec.data.data(), dec.stride) == 0,
+          "decimate2 sub-view failed");
+    Matches(dec, RefDecimate2(view), "decimate2 sub-view", 0.0f);
+
+    Image blur(w, h, 5);
+    CHECK(xnav_gaussian_blur(origin, w, h, parent.stride, blur.data.data(), blur.stride, 1.0f) == 1,
+          "blur sub-view failed");
+    Matches(blur, RefBlur(view, 1.0f), "blur sub-view", 1.0f);
+}
+
+void TestEdgeCases(std::mt19937& rng) {
+    uint8_t px[4] = {10, 20, 30, 41};
+    uint8_t out[4] = {0, 0, 0, 0};
+    CHECK(xnav_decimate2(px, 1, 1, 1, out, 1) == -1, "decimate2 1x1 must fail");
+    CHECK(xnav_decimate2(px, 2, 1, 2, out, 1) == -1, "decimate2 2x1 must fail");
+    CHECK(xnav_decimate2(nullptr, 2, 2, 2, out, 1) == -1, "decimate2 null src must fail");
+    CHECK(xnav_decimate2(px, 2, 2, 2, out, 1) == 0 && out[0] == 25, "decimate2 2x2 = %d", out[0]);
+    CHECK(xnav_gaussian_blur(px, 0, 1, 1, out, 1, 1.0f) == -1, "blur 0x1 must fail");
+    CHECK(xnav_gaussian_blur(px, 1, 1, 1, nullptr, 1, 1.0f) == -1, "blur null dst must fail");
+
+    // 1x1 blurs to itself; 2x2 and 1xN exercise the replicated borders
+    for (float sigma : {0.0f, 1.0f, 2.0f}) {
+        uint8_t one = 200;
+        CHECK(xnav_gaussian_blur(&one, 1, 1, 1, &one, 1, sigma) == RefPasses(sigma) && one == 200,
+              "blur 1x1 sigma %.2f = %d", sigma, one);
+        TestBlur(2, 2, 0, 0, sigma, rng);
+        TestBlur(2, 2, 3, 1, sigma, rng);
+        TestBlur(1, 9, 0, 2, sigma, rng);
+        TestBlur(9, 1, 0, 2, sigma, rng);
+    }
+    TestDecimate(2, 2, 0, 0, rng);
+    TestDecimate(3, 3, 1, 1, rng);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string active = xnav_simd_name();
+    if (argc > 1 && active != argv[1]) {
+        std::printf("kernel set %s not available (running %s), skipping\n", argv[1],
+                    active.c_str());
+        return kSkip;
+    }
+    std::printf("kernel set: %s\n", active.c_str());
+
+    std::mt19937 rng(0x5eed);
+    TestEdgeCases(rng);
+    TestSubView(rng);
+
+    // Widths straddle the 16/32-lane vector bodies and their scalar tails
+    const int widths[] = {3, 4, 5, 7, 15, 16, 17, 31, 32, 33, 35, 63, 64, 65, 66, 67, 129, 640};
+    const int heights[] = {2, 3, 5, 6, 17};
+    for (int w : widths) {
+        for (int h : heights) {
+            TestDecimate(w, h, 0, 0, rng);
+            TestDecimate(w, h, 13, 3, rng);
+            for (float sigma : {0.0f, 0.8f, 1.5f}) TestBlur(w, h, (w + h) % 9, h % 4, sigma, rng);
+        }
+    }
+    TestBlur(640, 480, 0, 0, 2.0f, rng);
+
+    if (g_failures != 0) {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("ok\n");
+    return 0;
+}
@@ -8,8 +8,7 @@ import cv2
 import math
 import time
 import logging
-from dataclasses import dataclass, field
-from typing import List, Optional, Tuple
+from typing import Dict, List, Optional, Tuple
 
 try:
     # dt-apriltags: maintained fork of pupil-apriltags with ARM64 wheels
@@ -24,61 +23,219 @@ except ImportError:
         _APRILTAG_AVAILABLE = False
         apriltag = None
 
+from calibration import mode_key, scale_intrinsics
+from frame_deadline import FrameAbandoned, FrameDeadline, NO_DEADLINE
+import native
+
 logger = logging.getLogger(__name__)
 
 
-@dataclass
-class TagDetection:
-    """3D detection result for a single AprilTag."""
-    id: int
-    # Camera-frame translation (meters)
-    x: float = 0.0
-    y: float = 0.0
-    z: float = 0.0
-    # Distance (meters)
-    distance: float = 0.0
-    # Angles from camera center (degrees)
-    tx: float = 0.0    # horizontal angle
-    ty: float = 0.0    # vertical angle
-    # Orientation (degrees)
-    yaw: float = 0.0
-    pitch: float = 0.0
-    roll: float = 0.0
-    # Image-space
-    cx: float = 0.0    # pixel center x
-    cy: float = 0.0    # pixel center y
-    corners: Optional[np.ndarray] = None
-    # Rotation matrix (3x3) and translation vector (3,)
-    rvec: Optional[np.ndarray] = None
-    tvec: Optional[np.ndarray] = None
-    # Hamming distance (tag confidence)
-    hamming: int = 0
-    decision_margin: float = 0.0
-    # Latency contribution
-    timestamp: float = 0.0
-
-
-def _rvec_to_euler(rvec: np.ndarray) -> Tuple[float, float, float]:
-    """Convert rotation vector to (roll, pitch, yaw) in degrees."""
-    R, _ = cv2.Rodrigues(rvec)
-    # Roll (x-axis rotation)
-    roll = math.degrees(math.atan2(R[2, 1], R[2, 2]))
-    # Pitch (y-axis rotation)
-    pitch = math.degrees(math.atan2(-R[2, 0], math.sqrt(R[2, 1] ** 2 + R[2, 2] ** 2)))
-    # Yaw (z-axis rotation)
-    yaw = math.degrees(math.atan2(R[1, 0], R[0, 0]))
-    return roll, pitch, yaw
+def _rotation_angle(R_a: np.ndarray, R_b: np.ndarray) -> float:
+    """Angle (radians) of the relative rotation between two rotation matrices."""
+    c = (np.trace(R_a.T @ R_b) - 1.0) / 2.0
+    return math.acos(max(-1.0, min(1.0, c)))
+
+
+class DetectionBatch:
+    """All detections of one frame as parallel arrays (row i = one tag).
+    Pipeline stages transform the arrays in place with vectorized numpy
+    instead of building and copying an object per tag."""
+
+    # Per-tag layout of pack(): id followed by these fields
+    PACK_FIELDS = ("tx", "ty", "x", "y", "z", "distance", "yaw", "pitch", "roll", "ambiguity")
+
+    def __init__(self, n: int = 0, camera_id: int = 0, timestamp: float = 0.0):
+        self.timestamp = timestamp
+        self.ids = np.zeros(n, dtype=np.int64)
+        self.camera_id = np.full(n, camera_id, dtype=np.int64)
+        self.corners = np.zeros((n, 4, 2))
+        self.center = np.zeros((n, 2))
+        self.hamming = np.zeros(n, dtype=np.int64)
+        self.margin = np.zeros(n)
+        # Chosen PnP solution (camera frame) and the rejected planar alternative
+        self.has_pose = np.zeros(n, dtype=bool)
+        self.R = np.tile(np.eye(3), (n, 1, 1))
+        self.t = np.zeros((n, 3))
+        self.has_alt = np.zeros(n, dtype=bool)
+        self.R_alt = np.tile(np.eye(3), (n, 1, 1))
+        self.t_alt = np.zeros((n, 3))
+        self.ambiguity = np.zeros(n)
+        self.reproj_error = np.zeros(n)
+        # Derived from (R, t); tx/ty fall back to the pixel angle without a pose
+        self.tx = np.zeros(n)
+        self.ty = np.zeros(n)
+        self.distance = np.zeros(n)
+        self.euler = np.zeros((n, 3))   # roll, pitch, yaw (deg)
+
+    def __len__(self) -> int:
+        return len(self.ids)
+
+    # Convenience column views
+    x = property(lambda self: self.t[:, 0])
+    y = property(lambda self: self.t[:, 1])
+    z = property(lambda self: self.t[:, 2])
+    roll = property(lambda self: self.euler[:, 0])
+    pitch = property(lambda self: self.euler[:, 1])
+    yaw = property(lambda self: self.euler[:, 2])
+
+    def update_derived(self):
+        """Recompute distance, angles and Euler angles of rows with a pose."""
+        m = self.has_pose
+        if not m.any():
+            return
+        t = self.t[m]
+        R = self.R[m]
+        self.distance[m] = np.linalg.norm(t, axis=1)
+        self.tx[m] = np.degrees(np.arctan2(t[:, 0], t[:, 2]))
+        self.ty[m] = -np.degrees(np.arctan2(t[:, 1], t[:, 2]))
+        self.euler[m, 0] = np.degrees(np.arctan2(R[:, 2, 1], R[:, 2, 2]))
+        self.euler[m, 1] = np.degrees(np.arctan2(-R[:, 2, 0], np.hypot(R[:, 2, 1], R[:, 2, 2])))
+        self.euler[m, 2] = np.degrees(np.arctan2(R[:, 1, 0], R[:, 0, 0]))
+
+    def rotate(self, R_frame: np.ndarray):
+        """Rotate every pose (both solutions) by a camera-frame rotation, e.g.
+        turret compensation."""
+        if not len(self):
+            return
+        self.t = self.t @ R_frame.T
+        self.R = np.matmul(R_frame, self.R)
+        self.t_alt = self.t_alt @ R_frame.T
+        self.R_alt = np.matmul(R_frame, self.R_alt)
+        self.update_derived()
+
+    def use_alternate(self, rows):
+        """Swap in the second PnP solution for the given rows (mask or indices)."""
+        rows = np.asarray(rows)
+        rows = np.flatnonzero(rows) if rows.dtype == bool else rows.astype(np.intp)
+        rows = rows[self.has_alt[rows]]
+        if not len(rows):
+            return
+        self.R[rows], self.R_alt[rows] = self.R_alt[rows].copy(), self.R[rows].copy()
+        self.t[rows], self.t_alt[rows] = self.t_alt[rows].copy(), self.t[rows].copy()
+        self.update_derived()
+
+    def select(self, rows) -> "DetectionBatch":
+        """New batch with only the given rows (mask or indices)."""
+        out = DetectionBatch(0, timestamp=self.timestamp)
+        for name, value in vars(self).items():
+            if isinstance(value, np.ndarray):
+                setattr(out, name, value[rows])
+        return out
+
+    @classmethod
+    def concat(cls, batches: List["DetectionBatch"]) -> "DetectionBatch":
+        batches = [b for b in batches if b is not None]
+        if len(batches) == 1:
+            return batches[0]
+        out = cls(0, timestamp=max((b.timestamp for b in batches), default=0.0))
+        for name, value in vars(out).items():
+            if isinstance(value, np.ndarray):
+                setattr(out, name, np.concatenate([getattr(b, name) for b in batches]))
+        return out
+
+    def closest_per_id(self) -> "DetectionBatch":
+        """One row per tag id: the closest observation (rows with a pose first)."""
+        if len(self) < 2:
+            return self
+        key = np.where(self.has_pose & (self.distance > 0), self.distance, np.inf)
+        order = np.lexsort((key, self.ids))
+        first = np.ones(len(order), dtype=bool)
+        first[1:] = self.ids[order][1:] != self.ids[order][:-1]
+        return self.select(np.sort(order[first]))
+
+    def primary_id(self) -> int:
+        """Id of the closest tag, -1 when empty."""
+        if not len(self):
+            return -1
+        return int(self.ids[int(np.argmin(self.distance))])
+
+    def pack(self) -> List[float]:
+        """Flat frame for NT: [count, then per tag: id, *PACK_FIELDS]."""
+        cols = np.column_stack([self.ids.astype(np.float64), self.tx, self.ty, self.t,
+                                self.distance, self.yaw, self.pitch, self.roll, self.ambiguity])
+        return [float(len(self))] + cols.ravel().tolist()
+
+    def to_dicts(self) -> List[dict]:
+        """Dashboard rows."""
+        return [{
+            "id": int(self.ids[i]),
+            "tx": round(float(self.tx[i]), 3),
+            "ty": round(float(self.ty[i]), 3),
+            "x": round(float(self.t[i, 0]), 4),
+            "y": round(float(self.t[i, 1]), 4),
+            "z": round(float(self.t[i, 2]), 4),
+            "distance": round(float(self.distance[i]), 4),
+            "yaw": round(float(self.euler[i, 2]), 2),
+            "pitch": round(float(self.euler[i, 1]), 2),
+            "roll": round(float(self.euler[i, 0]), 2),
+            "ambiguity": round(float(self.ambiguity[i]), 3),
+        } for i in range(len(self))]
+
+
+class UndistortLUT:
+    """Precomputed distorted -> ideal pixel map on a coarse grid for one
+    resolution. Corners are undistorted by bilinear interpolation between grid
+    nodes, which costs a few array ops per frame instead of remapping the
+    whole image or iterating cv2.undistortPoints per corner."""
+
+    def __init__(self, width: int, height: int, camera_matrix: np.ndarray,
+                 dist_coeffs: np.ndarray, step: int = 8):
+        self.width = width
+        self.height = height
+        self.step = max(1, int(step))
+        nx = (width - 1) // self.step + 2
+        ny = (height - 1) // self.step + 2
+        gx, gy = np.meshgrid(np.arange(nx, dtype=np.float64) * self.step,
+                             np.arange(ny, dtype=np.float64) * self.step)
+        pts = np.stack([gx.ravel(), gy.ravel()], axis=1).reshape(-1, 1, 2)
+        # P=K keeps the output in (undistorted) pixel units
+        ideal = cv2.undistortPoints(pts, camera_matrix, dist_coeffs, P=camera_matrix)
+        self._grid = ideal.reshape(ny, nx, 2).astype(np.float32)
+
+    def undistort(self, points: np.ndarray) -> np.ndarray:
+        """Map (..., 2) distorted pixel coordinates to ideal pixel coordinates."""
+        shape = points.shape
+        pts = np.asarray(points, dtype=np.float64).reshape(-1, 2)
+        ny, nx = self._grid.shape[:2]
+        gx = np.clip(pts[:, 0] / self.step, 0.0, nx - 1.000001)
+        gy = np.clip(pts[:, 1] / self.step, 0.0, ny - 1.000001)
+        x0 = gx.astype(np.intp)
+        y0 = gy.astype(np.intp)
+        fx = (gx - x0)[:, None]
+        fy = (gy - y0)[:, None]
+        g = self._grid
+        top = g[y0, x0] * (1.0 - fx) + g[y0, x0 + 1] * fx
+        bot = g[y0 + 1, x0] * (1.0 - fx) + g[y0 + 1, x0 + 1] * fx
+        return (top * (1.0 - fy) + bot * fy).reshape(shape)
 
 
 class AprilTagDetector:
     """Detects AprilTags and computes 3D pose."""
 
-    def __init__(self, config_manager):
+    def __init__(self, config_manager, camera_id: int = 0):
         self._cfg = config_manager
+        self._camera_id = camera_id
         self._detector = None
+        # Native AprilTag binding (zero-copy, flat results) when built
+        self._native: Optional[native.NativeTagDetector] = None
+        self._native_family = ""
+        # Detector pre-pass: (decimation factor, blur sigma) and its buffers
+        self._prepass: Tuple[int, float] = (1, 0.0)
+        self._prepass_bufs: Dict[Tuple[int, int], np.ndarray] = {}
+        # Runtime overrides of apriltag settings (quality controller)
+        self._overrides: Dict[str, float] = {}
         self._camera_matrix: Optional[np.ndarray] = None
         self._dist_coeffs: Optional[np.ndarray] = None
         self._tag_size: float = 0.1524  # default 6 inches in meters
+        # Calibrations per image size (w, h) -> (K, D); the active pair above
+        # follows the frame size, scaled from the closest calibrated mode
+        self._calibrations: Dict[Tuple[int, int], Tuple[np.ndarray, np.ndarray]] = {}
+        self._mode_cache: Dict[Tuple[int, int], Tuple[np.ndarray, np.ndarray]] = {}
+        self._active_size: Optional[Tuple[int, int]] = None
+        # Corner undistortion tables per image size, kept across mode switches
+        self._undistort_luts: Dict[Tuple[int, int], UndistortLUT] = {}
+        # Per-tag track of the last solutions: id -> (timestamp, R_chosen, R_other)
+        self._tracks: Dict[int, Tuple[float, np.ndarray, Optional[np.ndarray]]] = {}
         self._init_detector()
         self._load_calibration()
 
@@ -86,57 +243,184 @@ class AprilTagDetector:
     # Public API
     # ------------------------------------------------------------------
 
-    def detect(self, gray: np.ndarray, timestamp: float) -> List[TagDetection]:
-        """Run detection on a grayscale frame."""
-        if self._detector is None or gray is None:
-            return []
+    @property
+    def available(self) -> bool:
+        return self._native is not None or self._detector is not None
+
+    @property
+    def backend(self) -> str:
+        return "native" if self._native is not None else "python" if self._detector else "none"
+
+    def detect(self, gray: np.ndarray, timestamp: float,
+               rois: Optional[List[Tuple[int, int, int, int]]] = None,
+               deadline: FrameDeadline = NO_DEADLINE) -> DetectionBatch:
+        """Run detection on a grayscale frame. With rois ((x0, y0, x1, y1)
+        pixel windows), only those windows are searched. Raises
+        FrameAbandoned before detection or between ROI windows once the
+        deadline has passed; once tags are found the frame is finished."""
+        if not self.available or gray is None:
+            return DetectionBatch(0, self._camera_id, timestamp)
 
         try:
-            detections = self._detector.detect(
-                gray,
-                estimate_tag_pose=self._camera_matrix is not None,
-                camera_params=self._get_camera_params(gray),
-                tag_size=self._tag_size
-            )
+            deadline.check("detect")
+            img, scale = self._run_prepass(gray)
+            if scale > 1 and rois:
+                rois = [(x0 // scale, y0 // scale, -(-x1 // scale), -(-y1 // scale))
+                        for x0, y0, x1, y1 in rois]
+            if self._native is not None:
+                batch = self._detect_native(img, timestamp, rois)
+            else:
+                batch = self._detect_python(img, timestamp, rois, deadline)
+            if scale > 1:
+                # Box-decimated pixel i spans full pixels [i*s, (i+1)*s)
+                batch.corners *= scale
+                batch.center *= scale
+        except FrameAbandoned:
+            raise
         except Exception as e:
             logger.warning("Detection error: %s", e)
-            return []
+            return DetectionBatch(0, self._camera_id, timestamp)
+        return self.solve(batch, gray.shape[1], gray.shape[0])
+
+    def solve(self, batch: DetectionBatch, width: int, height: int) -> DetectionBatch:
+        """Fill angles and poses of a batch of tag corners seen in a
+        width x height frame (detected, or tracked between detections)."""
+        if not len(batch):
+            return batch
+        self._select_mode(width, height)
 
-        results = []
-        for d in detections:
-            tag = self._process_detection(d, gray, timestamp)
-            if tag is not None:
-                results.append(tag)
+        # Pixel angle from the image center (kept for tags without a pose)
+        fx, fy, cx_cam, cy_cam = self._intrinsics(width, height)
+        batch.tx[:] = np.degrees(np.arctan2(batch.center[:, 0] - cx_cam, fx))
+        batch.ty[:] = -np.degrees(np.arctan2(batch.center[:, 1] - cy_cam, fy))
 
-        return results
+        if self._camera_matrix is not None:
+            # With lens distortion, the library's pinhole-only pose is biased:
+            # undistort just the corners and re-solve the pose ourselves. The
+            # pose is always solved here (not by the library) so both planar
+            # solutions are available for ambiguity resolution.
+            lut = self._get_undistort_lut(width, height)
+            pose_corners = lut.undistort(batch.corners) if lut is not None else batch.corners
+            if self._native_pose():
+                self._solve_rows_native(batch, pose_corners, batch.timestamp)
+            else:
+                for i in range(len(batch)):
+                    self._solve_row(batch, i, pose_corners[i], batch.timestamp)
+            batch.update_derived()
+        return batch
+
+    def camera_matrix(self, width: int, height: int) -> np.ndarray:
+        """Intrinsics for this frame size (calibrated, scaled or estimated)."""
+        K, _ = self._calibration_for(width, height)
+        if K is not None:
+            return K
+        fx, fy, cx, cy = self._intrinsics(width, height)
+        return np.array([[fx, 0.0, cx], [0.0, fy, cy], [0.0, 0.0, 1.0]])
+
+    def warm_up(self, width: int, height: int):
+        """Run one detection on a blank frame so the library allocates its
+        buffers and thread pool before the first real frame arrives."""
+        if not self.available:
+            return
+        t0 = time.monotonic()
+        try:
+            blank = np.zeros((height, width), dtype=np.uint8)
+            if self._native is not None:
+                self._native.detect(blank)
+            else:
+                self._detector.detect(blank)
+        except Exception as e:
+            logger.debug("Detector warm-up failed: %s", e)
+            return
+        logger.info("Detector warmed up in %.1f ms", (time.monotonic() - t0) * 1000.0)
 
     def reload_config(self):
         self._init_detector()
         self._load_calibration()
 
-    def set_calibration(self, camera_matrix: np.ndarray, dist_coeffs: np.ndarray):
-        self._camera_matrix = camera_matrix
-        self._dist_coeffs = dist_coeffs
-        logger.info("Calibration updated in detector")
+    def set_operating_point(self, quad_decimate: Optional[float] = None,
+                            nthreads: Optional[int] = None):
+        """Run with this decimation / thread count instead of the configured
+        one (None restores the configured value). Applied in place: the
+        detector and its thread pool are kept."""
+        overrides = {}
+        if quad_decimate is not None:
+            overrides["quad_decimate"] = float(quad_decimate)
+        if nthreads is not None:
+            overrides["nthreads"] = int(nthreads)
+        if overrides == self._overrides:
+            return
+        self._overrides = overrides
+        at_cfg = self._at_cfg()
+        self._prepass = self._prepass_params(at_cfg)
+        params = self._tuning(at_cfg)
+        if self._native is not None:
+            self._native.configure(*params)
+        elif self._detector is not None:
+            self._tune_python(params)
+
+    def set_calibration(self, camera_matrix: np.ndarray, dist_coeffs: np.ndarray,
+                        image_size: Optional[Tuple[int, int]] = None):
+        """Install a calibration for one sensor mode (default: the configured
+        camera resolution). Other modes keep theirs."""
+        size = tuple(int(v) for v in image_size) if image_size else self._configured_size()
+        self._calibrations[size] = (np.asarray(camera_matrix, dtype=np.float64),
+                                    np.asarray(dist_coeffs, dtype=np.float64))
+        self._reset_modes()
+        self._tracks.clear()
+        logger.info("Calibration for %s updated in detector", mode_key(*size))
+
+    def flip_track(self, tag_id: int):
+        """Record that the other solution was finally used for this tag (e.g.
+        after an odometry override) so the next frame follows it."""
+        track = self._tracks.get(tag_id)
+        if track is not None and track[2] is not None:
+            self._tracks[tag_id] = (track[0], track[2], track[1])
 
     # ------------------------------------------------------------------
     # Internal
     # ------------------------------------------------------------------
 
+    def _at_cfg(self) -> dict:
+        """The apriltag section with the runtime overrides applied."""
+        at_cfg = self._cfg.get("apriltag") or {}
+        return {**at_cfg, **self._overrides} if self._overrides else at_cfg
+
+    def _tuning(self, at_cfg: dict) -> Tuple[int, float, float, bool, float]:
+        """(nthreads, quad_decimate, quad_sigma, refine_edges, decode_sharpening)
+        for the library, after the pre-pass takes its share."""
+        return (int(at_cfg.get("nthreads", 4)), self._library_decimate(at_cfg),
+                self._library_sigma(at_cfg), bool(at_cfg.get("refine_edges", 1)),
+                float(at_cfg.get("decode_sharpening", 0.25)))
+
+    def _tune_python(self, params):
+        """Retune dt-apriltags through its detector struct (the library
+        resizes its worker pool on the next detect); rebuild without it."""
+        td = getattr(self._detector, "tag_detector_ptr", None)
+        if td is None:
+            self._init_detector()
+            return
+        td = td.contents
+        td.nthreads, td.quad_decimate, td.quad_sigma, td.refine_edges, td.decode_sharpening = \
+            params[0], params[1], params[2], int(params[3]), params[4]
+
     def _init_detector(self):
+        at_cfg = self._at_cfg()
+        self._tag_size = float(at_cfg.get("tag_size", 0.1524))
+        self._prepass = self._prepass_params(at_cfg)
+        if self._init_native(at_cfg):
+            return
+
         if not _APRILTAG_AVAILABLE:
             logger.error("AprilTag library (dt-apriltags or pupil-apriltags) not installed. AprilTag detection unavailable.")
             return
 
-        at_cfg = self._cfg.get("apriltag") or {}
-        self._tag_size = float(at_cfg.get("tag_size", 0.1524))
-
         try:
             self._detector = apriltag.Detector(
                 families=at_cfg.get("family", "tag36h11"),
                 nthreads=int(at_cfg.get("nthreads", 4)),
-                quad_decimate=float(at_cfg.get("quad_decimate", 2.0)),
-                quad_sigma=float(at_cfg.get("quad_sigma", 0.0)),
+                quad_decimate=self._library_decimate(at_cfg),
+                quad_sigma=self._library_sigma(at_cfg),
                 refine_edges=int(at_cfg.get("refine_edges", 1)),
                 decode_sharpening=float(at_cfg.get("decode_sharpening", 0.25)),
                 debug=0
@@ -147,37 +431,222 @@ class AprilTagDetector:
             logger.error("Failed to init detector: %s", e)
             self._detector = None
 
-    def _load_calibration(self):
-        cal = self._cfg.get("calibration") or {}
-        mtx = cal.get("camera_matrix")
-        dist = cal.get("dist_coeffs")
-        if mtx and dist:
-            self._camera_matrix = np.array(mtx, dtype=np.float64)
-            self._dist_coeffs = np.array(dist, dtype=np.float64)
-            logger.info("Loaded calibration from config")
+    def _init_native(self, at_cfg: dict) -> bool:
+        """Use the native binding unless backend is "python". Returns True
+        when it is active; "auto" falls back to dt-apriltags quietly."""
+        backend = at_cfg.get("backend", "auto")
+        if backend == "python":
+            self._close_native()
+            return False
+        params = self._tuning(at_cfg)
+        family = at_cfg.get("family", "tag36h11")
+        if self._native is not None and self._native_family == family:
+            # Keep the detector (and its thread pool) across tuning changes
+            self._native.configure(*params)
+            return True
+        self._close_native()
+        if not native.has_apriltag():
+            if backend == "native":
+                logger.warning("Native AprilTag backend requested but libxnav_native is not "
+                               "built with libapriltag; using dt-apriltags")
+            return False
+        try:
+            self._native = native.NativeTagDetector(family, *params)
+        except (RuntimeError, ValueError) as e:
+            logger.warning("Native AprilTag detector unavailable (%s); using dt-apriltags", e)
+            return False
+        self._native_family = family
+        self._detector = None
+        logger.info("AprilTag detector initialized (native): family=%s nthreads=%d",
+                    family, params[0])
+        return True
+
+    def _prepass_params(self, at_cfg: dict) -> Tuple[int, float]:
+        """(factor, sigma) of the native pre-pass; (1, 0) when it is off. The
+        factor is quad_decimate rounded down to 1, 2 or 4."""
+        if not at_cfg.get("prepass", False):
+            return (1, 0.0)
+        if native.lib is None:
+            logger.warning("apriltag.prepass needs libxnav_native; decimating in the detector")
+            return (1, 0.0)
+        decimate = float(at_cfg.get("quad_decimate", 2.0))
+        factor = 4 if decimate >= 4 else 2 if decimate >= 2 else 1
+        sigma = max(0.0, float(at_cfg.get("quad_sigma", 0.0)))
+        logger.info("Detector pre-pass: decimate x%d, blur sigma %.2f (%s kernels)",
+                    factor, sigma, native.lib.xnav_simd_name().decode())
+        return (factor, sigma)
+
+    def _library_decimate(self, at_cfg: dict) -> float:
+        return 1.0 if self._prepass != (1, 0.0) else float(at_cfg.get("quad_decimate", 2.0))
+
+    def _library_sigma(self, at_cfg: dict) -> float:
+        sigma = float(at_cfg.get("quad_sigma", 0.0))
+        # The pre-pass blurs; negative sigma (sharpening) stays with the library
+        return 0.0 if self._prepass != (1, 0.0) and sigma >= 0 else sigma
+
+    def _run_prepass(self, gray: np.ndarray) -> Tuple[np.ndarray, int]:
+        """Decimate and blur with the native kernels into per-size buffers.
+        Returns (image for the detector, factor to scale its corners by)."""
+        factor, sigma = self._prepass
+        if factor == 1 and sigma <= 0:
+            return gray, 1
+        img = gray
+        for _ in range(factor.bit_length() - 1):
+            shape = (img.shape[0] // 2, img.shape[1] // 2)
+            dst = self._prepass_bufs.get(shape)
+            if dst is None:
+                dst = self._prepass_bufs[shape] = np.empty(shape, dtype=np.uint8)
+            img = native.decimate2(img, dst)
+        if sigma > 0:
+            if img is gray:
+                dst = self._prepass_bufs.get(gray.shape)
+                if dst is None:
+                    dst = self._prepass_bufs[gray.shape] = np.empty(gray.shape, dtype=np.uint8)
+                img = native.gaussian_blur(gray, sigma, dst)
+            else:
+                native.gaussian_blur(img, sigma, img)
+        return img, factor
+
+    def _close_native(self):
+        if self._native is not None:
+            self._native.close()
+            self._native = None
+
+    def _detect_native(self, gray: np.ndarray, timestamp: float, rois) -> DetectionBatch:
+        """Native path: the frame (and ROI windows into it) is read in place
+        and results are copied straight from the flat result arrays."""
+        ids, hamming, margin, centers, corners = self._native.detect(gray, rois)
+        batch = DetectionBatch(len(ids), self._camera_id, timestamp)
+        batch.ids[:] = ids
+        batch.hamming[:] = hamming
+        batch.margin[:] = margin
+        batch.center[:] = centers
+        batch.corners[:] = corners
+        return batch
+
+    def _detect_python(self, gray: np.ndarray, timestamp: float, rois,
+                       deadline: FrameDeadline) -> DetectionBatch:
+        if rois:
+            detections = self._detect_rois(gray, rois, deadline)
         else:
-            # Try loading from calibration file
-            cal_file = cal.get("calibration_file", "")
-            if cal_file:
-                import json, os
-                if os.path.exists(cal_file):
-                    try:
-                        with open(cal_file) as f:
-                            d = json.load(f)
-                        self._camera_matrix = np.array(d["camera_matrix"], dtype=np.float64)
-                        self._dist_coeffs = np.array(d["dist_coeffs"], dtype=np.float64)
-                        logger.info("Loaded calibration from file: %s", cal_file)
-                        return
-                    except Exception as e:
-                        logger.warning("Could not load calibration file: %s", e)
+            detections = self._detector.detect(gray, estimate_tag_pose=False)
+        batch = DetectionBatch(len(detections), self._camera_id, timestamp)
+        if not detections:
+            return batch
+        batch.ids[:] = [d.tag_id for d in detections]
+        batch.corners[:] = [d.corners for d in detections]
+        batch.center[:] = [d.center for d in detections]
+        batch.hamming[:] = [d.hamming for d in detections]
+        batch.margin[:] = [d.decision_margin for d in detections]
+        return batch
 
+    def _load_calibration(self):
+        """Load every calibrated sensor mode: the 'modes' table (config, then
+        calibration file) plus the legacy single camera_matrix/dist_coeffs,
+        taken to be at 'image_size' or else the configured resolution."""
+        cal = self._cfg.camera_section(self._camera_id, "calibration")
+        calibrations = {}
+        sources = [cal]
+        cal_file = cal.get("calibration_file", "")
+        if cal_file:
+            import json, os
+            if os.path.exists(cal_file):
+                try:
+                    with open(cal_file) as f:
+                        sources.append(json.load(f))
+                except Exception as e:
+                    logger.warning("Could not load calibration file: %s", e)
+
+        for src in sources:
+            for entry in (src.get("modes") or {}).values():
+                self._add_calibration(calibrations, entry, None)
+            self._add_calibration(calibrations, src, self._configured_size())
+
+        self._calibrations = calibrations
+        self._reset_modes()
+        if calibrations:
+            logger.info("Loaded calibration for %s",
+                        ", ".join(mode_key(*k) for k in sorted(calibrations)))
+        else:
             logger.warning("No calibration found - using default intrinsics. Accuracy will be reduced.")
-            self._camera_matrix = None
-            self._dist_coeffs = None
 
-    def _get_camera_params(self, gray: np.ndarray):
-        """Return (fx, fy, cx, cy) for the apriltag detector."""
-        h, w = gray.shape[:2]
+    @staticmethod
+    def _add_calibration(calibrations: dict, entry: dict, default_size):
+        mtx = entry.get("camera_matrix")
+        dist = entry.get("dist_coeffs")
+        size = entry.get("image_size") or default_size
+        if not (mtx and dist and size):
+            return
+        key = (int(size[0]), int(size[1]))
+        # Earlier sources (config) win over later ones (file)
+        if key not in calibrations:
+            calibrations[key] = (np.array(mtx, dtype=np.float64),
+                                 np.array(dist, dtype=np.float64))
+
+    def _configured_size(self) -> Tuple[int, int]:
+        cam = self._cfg.camera_section(self._camera_id, "camera")
+        return int(cam.get("width", 1280)), int(cam.get("height", 720))
+
+    def _reset_modes(self):
+        # The next frame re-selects its intrinsics
+        self._mode_cache = {}
+        self._undistort_luts = {}
+        self._active_size = None
+
+    def _calibration_for(self, width: int, height: int):
+        """(K, D) for an image size: an exact calibration if there is one,
+        otherwise the closest-aspect (then largest) calibrated mode scaled to
+        this size. (None, None) when uncalibrated."""
+        size = (int(width), int(height))
+        cached = self._mode_cache.get(size)
+        if cached is not None:
+            return cached
+        if not self._calibrations:
+            return None, None
+        if size in self._calibrations:
+            result = self._calibrations[size]
+        else:
+            aspect = size[0] / float(size[1])
+            src = min(self._calibrations,
+                      key=lambda k: (round(abs(k[0] / float(k[1]) - aspect), 3), -k[0] * k[1]))
+            K, D = self._calibrations[src]
+            result = (scale_intrinsics(K, src, size), D)
+            if abs(src[0] / float(src[1]) - aspect) > 0.01:
+                logger.warning("No calibration for %s; scaling %s across aspect ratios "
+                               "(accurate only if the mode is not cropped)",
+                               mode_key(*size), mode_key(*src))
+            else:
+                logger.info("Intrinsics for %s scaled from %s calibration",
+                            mode_key(*size), mode_key(*src))
+        self._mode_cache[size] = result
+        return result
+
+    def _select_mode(self, width: int, height: int):
+        """Point the active intrinsics at this frame size (after a mode switch)."""
+        if self._active_size == (width, height):
+            return
+        self._camera_matrix, self._dist_coeffs = self._calibration_for(width, height)
+        self._active_size = (width, height)
+
+    def _detect_rois(self, gray: np.ndarray, rois, deadline: FrameDeadline):
+        """Detect inside each (non-overlapping) window and shift the results
+        back to full-frame pixel coordinates."""
+        found = {}
+        for x0, y0, x1, y1 in rois:
+            deadline.check("detect")
+            crop = np.ascontiguousarray(gray[y0:y1, x0:x1])
+            if crop.shape[0] < 8 or crop.shape[1] < 8:
+                continue
+            offset = np.array([x0, y0], dtype=np.float64)
+            for d in self._detector.detect(crop, estimate_tag_pose=False):
+                d.corners = np.asarray(d.corners, dtype=np.float64) + offset
+                d.center = np.asarray(d.center, dtype=np.float64) + offset
+                prev = found.get(d.tag_id)
+                if prev is None or d.decision_margin > prev.decision_margin:
+                    found[d.tag_id] = d
+        return list(found.values())
+
+    def _intrinsics(self, w: int, h: int):
         if self._camera_matrix is not None:
             fx = self._camera_matrix[0, 0]
             fy = self._camera_matrix[1, 1]
@@ -190,41 +659,98 @@ class AprilTagDetector:
             cy = h / 2.0
         return (fx, fy, cx, cy)
 
-    def _process_detection(self, d, gray: np.ndarray, timestamp: float) -> Optional[TagDetection]:
-        """Convert a raw apriltag detection to TagDetection."""
-        h, w = gray.shape[:2]
-        fx, fy, cx_cam, cy_cam = self._get_camera_params(gray)
-
-        tag = TagDetection(id=int(d.tag_id), timestamp=timestamp)
-        tag.hamming = int(d.hamming)
-        tag.decision_margin = float(d.decision_margin)
-        tag.corners = d.corners
-        tag.cx = float(d.center[0])
-        tag.cy = float(d.center[1])
-
-        # Pixel-angle (from image center)
-        tag.tx = math.degrees(math.atan2(tag.cx - cx_cam, fx))
-        tag.ty = -math.degrees(math.atan2(tag.cy - cy_cam, fy))
-
-        if hasattr(d, "pose_t") and d.pose_t is not None:
-            tvec = d.pose_t.flatten()
-            rvec_mat = d.pose_R
-            rvec, _ = cv2.Rodrigues(np.array(rvec_mat, dtype=np.float64))
-            tag.tvec = tvec
-            tag.rvec = rvec
-
-            # Camera-frame coordinates
-            tag.x = float(tvec[0])
-            tag.y = float(tvec[1])
-            tag.z = float(tvec[2])
-            tag.distance = float(np.linalg.norm(tvec))
-
-            # Update angles from actual 3D position
-            tag.tx = math.degrees(math.atan2(tag.x, tag.z))
-            tag.ty = -math.degrees(math.atan2(tag.y, tag.z))
-
-            tag.roll, tag.pitch, tag.yaw = _rvec_to_euler(rvec)
-        else:
-            tag.distance = 0.0
+    def _get_undistort_lut(self, w: int, h: int) -> Optional[UndistortLUT]:
+        """Return the corner undistortion table for this frame size, building it
+        on first use. None when there is no calibration or no distortion."""
+        if self._camera_matrix is None or self._dist_coeffs is None:
+            return None
+        at_cfg = self._cfg.get("apriltag") or {}
+        if not at_cfg.get("undistort_corners", True):
+            return None
+        if not np.any(np.abs(self._dist_coeffs) > 1e-9):
+            return None
+
+        lut = self._undistort_luts.get((w, h))
+        if lut is None:
+            step = int(at_cfg.get("undistort_lut_step", 8))
+            t0 = time.monotonic()
+            lut = UndistortLUT(w, h, self._camera_matrix, self._dist_coeffs, step)
+            self._undistort_luts[(w, h)] = lut
+            logger.info("Corner undistortion table built for %dx%d (step %d px) in %.1f ms",
+                        w, h, lut.step, (time.monotonic() - t0) * 1000.0)
+        return lut
+
+    def _solve_tag_pose(self, corners: np.ndarray) -> List[Tuple[np.ndarray, np.ndarray, np.ndarray, float]]:
+        """Solve both planar (IPPE) solutions from undistorted corners.
+        Returns [(R, rvec, tvec, reprojection_error)] sorted best first.
+        Corner order matches apriltag's estimate_tag_pose object points."""
+        s = self._tag_size / 2.0
+        obj = np.array([[-s, s, 0], [s, s, 0], [s, -s, 0], [-s, -s, 0]], dtype=np.float64)
+        try:
+            n, rvecs, tvecs, errs = cv2.solvePnPGeneric(
+                obj, np.asarray(corners, dtype=np.float64).reshape(4, 1, 2),
+                self._camera_matrix, None, flags=cv2.SOLVEPNP_IPPE_SQUARE)
+        except cv2.error as e:
+            logger.debug("Tag pose solve failed: %s", e)
+            return []
+        errs = np.asarray(errs, dtype=np.float64).flatten() if errs is not None else np.zeros(n)
+        cands = []
+        for i in range(n):
+            R, _ = cv2.Rodrigues(rvecs[i])
+            cands.append((R, rvecs[i], tvecs[i], float(errs[i])))
+        cands.sort(key=lambda c: c[3])
+        return cands
+
+    def _choose_solution(self, tag_id: int, timestamp: float, cands):
+        """Pick between the two planar solutions. Clear winners are kept; for
+        ambiguous ones the solution closest in rotation to this tag's previous
+        pose wins. Returns (chosen, other, ambiguity)."""
+        best = cands[0]
+        if len(cands) < 2:
+            self._tracks[tag_id] = (timestamp, best[0], None)
+            return best, None, 0.0
+        other = cands[1]
+        ambiguity = best[3] / other[3] if other[3] > 1e-12 else 0.0
 
-        return tag
+        at_cfg = self._cfg.get("apriltag") or {}
+        threshold = float(at_cfg.get("ambiguity_threshold", 0.2))
+        timeout = float(at_cfg.get("ambiguity_track_timeout_s", 0.5))
+        track = self._tracks.get(tag_id)
+        if ambiguity >= threshold and track is not None and timestamp - track[0] <= timeout:
+            R_prev = track[1]
+            if _rotation_angle(R_prev, other[0]) < _rotation_angle(R_prev, best[0]):
+                best, other = other, best
+
+        self._tracks[tag_id] = (timestamp, best[0], other[0])
+        return best, other, ambiguity
+
+    def _native_pose(self) -> bool:
+        at_cfg = self._cfg.get("apriltag") or {}
+        return native.lib is not None and at_cfg.get("backend", "auto") != "python"
+
+    def _solve_rows_native(self, batch: DetectionBatch, corners: np.ndarray, timestamp: float):
+        """Closed-form IPPE for every row in one native call (same solutions
+        and errors as SOLVEPNP_IPPE_SQUARE)."""
+        R, t, err, ok = native.solve_square_poses(corners, self._camera_matrix, self._tag_size)
+        for i in np.flatnonzero(ok):
+            cands = [(R[i, 0], None, t[i, 0], float(err[i, 0])),
+                     (R[i, 1], None, t[i, 1], float(err[i, 1]))]
+            self._apply_solution(batch, i, cands, timestamp)
+
+    def _solve_row(self, batch: DetectionBatch, i: int, corners: np.ndarray, timestamp: float):
+        """Solve one tag's pose from undistorted corners into batch row i."""
+        cands = self._solve_tag_pose(corners)
+        if cands:
+            self._apply_solution(batch, i, cands, timestamp)
+
+    def _apply_solution(self, batch: DetectionBatch, i: int, cands, timestamp: float):
+        """Store the chosen candidate (and the planar alternative) in row i."""
+        chosen, other, batch.ambiguity[i] = self._choose_solution(int(batch.ids[i]), timestamp, cands)
+        batch.reproj_error[i] = chosen[3]
+        batch.has_pose[i] = True
+        batch.R[i] = chosen[0]
+        batch.t[i] = np.asarray(chosen[2], dtype=np.float64).ravel()
+        if other is not None:
+            batch.has_alt[i] = True
+            batch.R_alt[i] = other[0]
+            batch.t_alt[i] = np.asarray(other[2], dtype=np.float64).ravel()
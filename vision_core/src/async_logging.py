@@ -0,0 +1,125 @@
+"""
+XNav Async Logging
+
+Keeps log I/O off the frame path. Callers only format the record and push it
+onto a bounded in-memory queue; a single writer thread owns the stdout and
+file handlers, including file rotation. Repeated messages (same logger, level
+and format string) are rate-limited before they are queued, and the next
+message that gets through reports how many were suppressed. When the queue is
+full, records are dropped and counted rather than blocking the caller.
+"""
+
+import sys
+import os
+import time
+import queue
+import logging
+import logging.handlers
+import threading
+
+LOG_FORMAT = "%(asctime)s [%(levelname)s] %(name)s: %(message)s"
+LOG_FILE = "/var/log/xnav.log"
+
+
+class RateLimitFilter(logging.Filter):
+    """Allow at most `burst` records per `interval` seconds for each
+    (logger, level, format string) key."""
+
+    _MAX_KEYS = 1024
+
+    def __init__(self, interval: float = 10.0, burst: int = 2):
+        super().__init__()
+        self._interval = interval
+        self._burst = burst
+        self._lock = threading.Lock()
+        # key -> [window_start, count_in_window, suppressed]
+        self._state: dict = {}
+
+    def filter(self, record: logging.LogRecord) -> bool:
+        key = (record.name, record.levelno, record.msg)
+        now = time.monotonic()
+        with self._lock:
+            st = self._state.get(key)
+            if st is None or now - st[0] >= self._interval:
+                suppressed = st[2] if st else 0
+                if len(self._state) >= self._MAX_KEYS:
+                    self._state.clear()
+                self._state[key] = [now, 1, 0]
+                if suppressed:
+                    record.msg = f"{record.msg} [{suppressed} similar messages suppressed]"
+                return True
+            st[1] += 1
+            if st[1] <= self._burst:
+                return True
+            st[2] += 1
+            return False
+
+
+class DroppingQueueHandler(logging.handlers.QueueHandler):
+    """QueueHandler that never blocks: a full queue drops the record."""
+
+    def __init__(self, q: queue.Queue):
+        super().__init__(q)
+        self.dropped = 0
+
+    def enqueue(self, record: logging.LogRecord):
+        try:
+            self.queue.put_nowait(record)
+        except queue.Full:
+            self.dropped += 1
+
+
+_listener: logging.handlers.QueueListener = None
+_queue_handler: DroppingQueueHandler = None
+
+
+def setup_async_logging(level: int, log_file: str = LOG_FILE,
+                        max_bytes: int = 5 * 1024 * 1024, backup_count: int = 3,
+                        queue_size: int = 10000,
+                        rate_interval: float = 10.0, rate_burst: int = 2):
+    """Route the root logger through a bounded queue to a writer thread."""
+    global _listener, _queue_handler
+    shutdown_async_logging()
+
+    formatter = logging.Formatter(LOG_FORMAT)
+    sinks = [logging.StreamHandler(sys.stdout)]
+    if log_file and os.path.isdir(os.path.dirname(log_file)):
+        try:
+            # Rotation runs inside the listener thread, never on the caller
+            sinks.append(logging.handlers.RotatingFileHandler(
+                log_file, mode="a", maxBytes=max_bytes, backupCount=backup_count))
+        except OSError as e:
+            print(f"Could not open log file {log_file}: {e}", file=sys.stderr)
+    for h in sinks:
+        h.setFormatter(formatter)
+
+    q = queue.Queue(maxsize=queue_size)
+    _queue_handler = DroppingQueueHandler(q)
+    _queue_handler.addFilter(RateLimitFilter(rate_interval, rate_burst))
+
+    root = logging.getLogger()
+    for h in list(root.handlers):
+        root.removeHandler(h)
+    root.addHandler(_queue_handler)
+    root.setLevel(level)
+
+    _listener = logging.handlers.QueueListener(q, *sinks, respect_handler_level=True)
+    _listener.start()
+
+
+def dropped_count() -> int:
+    """Records dropped because the queue was full."""
+    return _queue_handler.dropped if _queue_handler else 0
+
+
+def shutdown_async_logging():
+    """Flush pending records and stop the writer thread."""
+    global _listener
+    if _listener is not None:
+        _listener.stop()
+        for h in _listener.handlers:
+            try:
+                h.close()
+            except Exception:
+                pass
+        _listener = None
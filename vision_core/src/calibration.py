@@ -12,8 +12,35 @@ import threading
 import time
 from typing import Optional, List, Tuple
 
+from frame_deadline import FrameDeadline, NO_DEADLINE
+
 logger = logging.getLogger(__name__)
 
+# Checkerboard search runs on the smallest pyramid level at least this wide
+_SEARCH_WIDTH = 640
+
+
+def mode_key(width: int, height: int) -> str:
+    """Key for per-sensor-mode calibrations, e.g. '1280x720'."""
+    return f"{int(width)}x{int(height)}"
+
+
+def scale_intrinsics(camera_matrix: np.ndarray, from_size: Tuple[int, int],
+                     to_size: Tuple[int, int]) -> np.ndarray:
+    """Rescale a camera matrix calibrated at from_size (w, h) to to_size.
+    Valid for binned/scaled modes with the same field of view (not crops).
+    Distortion coefficients act on normalized coordinates and do not change."""
+    sx = to_size[0] / float(from_size[0])
+    sy = to_size[1] / float(from_size[1])
+    K = np.array(camera_matrix, dtype=np.float64).copy()
+    K[0, 0] *= sx
+    K[0, 1] *= sx
+    K[1, 1] *= sy
+    # Principal point scales about the pixel-center convention (centers at +0.5)
+    K[0, 2] = (K[0, 2] + 0.5) * sx - 0.5
+    K[1, 2] = (K[1, 2] + 0.5) * sy - 0.5
+    return K
+
 
 class CalibrationManager:
     """Manages camera calibration with a checkerboard pattern."""
@@ -46,26 +73,33 @@ class CalibrationManager:
             self._is_collecting = False
             self._last_status = "stopped"
 
-    def add_frame(self, gray: np.ndarray) -> bool:
-        """Try to find checkerboard in frame and add if found."""
+    def add_frame(self, frame, deadline: FrameDeadline = NO_DEADLINE) -> bool:
+        """Try to find checkerboard in a pooled frame and add it if found.
+        Past the frame's deadline the search is skipped: collection only
+        needs some of the frames, and a later one is already waiting."""
         with self._lock:
             if not self._is_collecting:
                 return False
             if self._progress >= self._target_frames:
                 return False
+        if deadline.expired():
+            return False
 
         cal = self._cfg.get("calibration") or {}
         rows = int(cal.get("checkerboard_rows", 6))
         cols = int(cal.get("checkerboard_cols", 9))
         pattern = (cols, rows)
 
+        # Presence check on a reduced pyramid level; the full-resolution frame
+        # is kept, and corners are refined on it in compute_calibration()
         flags = cv2.CALIB_CB_ADAPTIVE_THRESH | cv2.CALIB_CB_NORMALIZE_IMAGE | cv2.CALIB_CB_FAST_CHECK
-        found, _ = cv2.findChessboardCorners(gray, pattern, flags)
+        found, _ = cv2.findChessboardCorners(frame.level(frame.level_for_width(_SEARCH_WIDTH)),
+                                             pattern, flags)
 
         if found:
             with self._lock:
                 if self._progress < self._target_frames:
-                    self._calibration_frames.append(gray.copy())
+                    self._calibration_frames.append(frame.gray.copy())
                     self._progress += 1
                     logger.debug("Calibration frame %d/%d", self._progress, self._target_frames)
                     if self._progress >= self._target_frames:
@@ -160,15 +194,16 @@ class CalibrationManager:
         with self._lock:
             return dict(self._result) if self._result else None
 
-    def draw_preview(self, frame: np.ndarray) -> np.ndarray:
-        """Draw checkerboard corners on frame for live preview."""
+    def draw_preview(self, frame) -> np.ndarray:
+        """Live preview of a pooled frame with the checkerboard corners drawn,
+        rendered from a reduced pyramid level (the stream is shown small)."""
         cal = self._cfg.get("calibration") or {}
         rows = int(cal.get("checkerboard_rows", 6))
         cols = int(cal.get("checkerboard_cols", 9))
         pattern = (cols, rows)
-        gray = cv2.cvtColor(frame, cv2.COLOR_BGR2GRAY) if len(frame.shape) == 3 else frame
+        gray = frame.level(frame.level_for_width(_SEARCH_WIDTH))
         found, corners = cv2.findChessboardCorners(gray, pattern)
-        out = cv2.cvtColor(gray, cv2.COLOR_GRAY2BGR) if len(frame.shape) == 2 else frame.copy()
+        out = cv2.cvtColor(gray, cv2.COLOR_GRAY2BGR)
         if found:
             cv2.drawChessboardCorners(out, pattern, corners, found)
         return out
@@ -180,15 +215,34 @@ class CalibrationManager:
     def _save_calibration(self, result: dict):
         cal = self._cfg.get("calibration") or {}
         cal_file = cal.get("calibration_file", "/etc/xnav/calibration.json")
+        # Calibrations are kept per sensor mode, so calibrating one resolution
+        # does not discard another
+        key = mode_key(*result["image_size"])
+        entry = {k: result[k] for k in ("camera_matrix", "dist_coeffs", "image_size", "rms_error")}
         try:
             os.makedirs(os.path.dirname(cal_file), exist_ok=True)
+            modes = {}
+            if os.path.exists(cal_file):
+                try:
+                    with open(cal_file) as f:
+                        modes = json.load(f).get("modes") or {}
+                except (OSError, ValueError):
+                    modes = {}
+            modes[key] = entry
             with open(cal_file, "w") as f:
-                json.dump(result, f, indent=2)
-            logger.info("Calibration saved to %s", cal_file)
+                json.dump(dict(result, modes=modes), f, indent=2)
+            logger.info("Calibration for %s saved to %s", key, cal_file)
 
             # Also update in config
-            self._cfg.set("calibration", "camera_matrix", result["camera_matrix"])
-            self._cfg.set("calibration", "dist_coeffs", result["dist_coeffs"])
+            cfg_modes = dict(cal.get("modes") or {})
+            cfg_modes[key] = entry
+            self._cfg.update_section("calibration", dict(
+                cal,
+                camera_matrix=result["camera_matrix"],
+                dist_coeffs=result["dist_coeffs"],
+                image_size=result["image_size"],
+                modes=cfg_modes,
+            ))
         except Exception as e:
             logger.error("Failed to save calibration: %s", e)
 
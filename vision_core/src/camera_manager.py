@@ -5,31 +5,55 @@ Supports V4L2 cameras on Raspberry Pi CM.
 """
 
 import cv2
+import os
 import threading
 import time
 import logging
 import numpy as np
 from typing import Optional, Tuple, Callable
 
+import fake_camera
+from device_watcher import DeviceWatcher
+from frame_pool import FramePool, FrameBuffer
+
 logger = logging.getLogger(__name__)
 
+# Consecutive failed reads before the device is treated as disconnected
+_MAX_READ_FAILURES = 10
+_READ_TIMEOUT_MS = 500
+# Pooled frame buffers: one being filled, the latest, plus slack for readers
+_FRAME_BUFFERS = 4
+
 
 class CameraManager:
     """Manages a camera capture device and exposes frames to consumers."""
 
-    def __init__(self, config_manager):
+    def __init__(self, config_manager, camera_id: int = 0):
         self._cfg = config_manager
+        self._camera_id = camera_id
         self._cap: Optional[cv2.VideoCapture] = None
         self._lock = threading.Lock()
-        self._latest_frame: Optional[np.ndarray] = None
-        self._latest_gray: Optional[np.ndarray] = None
-        self._frame_time: float = 0.0
+        # Latest frame (holds one pool reference); replaced under _lock
+        self._pool = FramePool(_FRAME_BUFFERS)
+        self._latest: Optional[FrameBuffer] = None
         self._running = False
         self._thread: Optional[threading.Thread] = None
         self._fps_actual: float = 0.0
         self._frame_count: int = 0
         self._fps_t0: float = 0.0
         self._on_frame_callbacks: list = []
+        self._on_frame_start_callbacks: list = []
+        self._frame_period: float = 0.0
+        self._last_frame_ts: float = 0.0
+        # Active (width, height, fps) and a requested switch, applied between reads
+        self._mode: Optional[Tuple[int, int, int]] = None
+        self._mode_name: str = ""
+        self._pending_mode: Optional[Tuple[int, int, int]] = None
+        self._last_switch_ms: float = 0.0
+        # Hotplug recovery: outage start, count and last outage length
+        self._lost_at: Optional[float] = None
+        self._disconnects: int = 0
+        self._last_recovery_ms: float = 0.0
 
     # ------------------------------------------------------------------
     # Lifecycle
@@ -37,9 +61,10 @@ class CameraManager:
 
     def start(self):
         self._running = True
-        self._thread = threading.Thread(target=self._capture_loop, daemon=True, name="CamCapture")
+        name = "CamCapture" if self._camera_id == 0 else f"CamCapture-{self._camera_id}"
+        self._thread = threading.Thread(target=self._capture_loop, daemon=True, name=name)
         self._thread.start()
-        logger.info("Camera manager started")
+        logger.info("Camera manager %d started", self._camera_id)
 
     def stop(self):
         self._running = False
@@ -47,9 +72,11 @@ class CameraManager:
             self._thread.join(timeout=3)
         if self._cap:
             self._cap.release()
-        logger.info("Camera manager stopped")
+        logger.info("Camera manager %d stopped", self._camera_id)
 
     def restart(self):
+        """Full teardown and reopen. Resolution/fps changes do not need this;
+        use set_mode() / select_mode()."""
         self.stop()
         time.sleep(0.5)
         self.start()
@@ -59,21 +86,86 @@ class CameraManager:
     # ------------------------------------------------------------------
 
     def get_frame(self) -> Tuple[Optional[np.ndarray], Optional[np.ndarray], float]:
-        """Returns (color_frame, gray_frame, timestamp)."""
+        """Returns copies of (color_frame, gray_frame, timestamp), safe to keep.
+        Prefer acquire_latest() for short-lived, copy-free access."""
+        buf = self.acquire_latest()
+        if buf is None:
+            return None, None, 0.0
+        with buf:
+            return buf.bgr.copy(), buf.gray.copy(), buf.timestamp
+
+    def acquire_latest(self) -> Optional[FrameBuffer]:
+        """The latest frame buffer by reference, retained for the caller, who
+        must release() it (or use it as a context manager). Frame callbacks
+        get the arrays directly and must not keep them past the call."""
         with self._lock:
-            return (
-                self._latest_frame.copy() if self._latest_frame is not None else None,
-                self._latest_gray.copy() if self._latest_gray is not None else None,
-                self._frame_time
-            )
+            buf = self._latest
+            return buf.retain() if buf is not None else None
 
     def get_fps(self) -> float:
         return self._fps_actual
 
+    @property
+    def frame_period(self) -> float:
+        """Smoothed interval between frames (s), 0 before the first frame."""
+        return self._frame_period
+
+    @property
+    def camera_id(self) -> int:
+        return self._camera_id
+
+    @property
+    def name(self) -> str:
+        return str(self._cam_cfg().get("name", f"cam{self._camera_id}"))
+
+    @property
+    def mode(self) -> Optional[Tuple[int, int, int]]:
+        """Active (width, height, fps), None before the camera opens."""
+        return self._mode
+
+    def get_mode_status(self) -> dict:
+        w, h, fps = self._mode or (0, 0, 0)
+        return {"name": self._mode_name, "width": w, "height": h, "fps": fps,
+                "last_switch_ms": round(self._last_switch_ms, 1)}
+
+    def get_health(self) -> dict:
+        """Connection state and hotplug recovery metrics."""
+        return {"connected": self._lost_at is None and self._cap is not None,
+                "disconnects": self._disconnects,
+                "last_recovery_ms": round(self._last_recovery_ms, 1)}
+
+    def select_mode(self, name: str = ""):
+        """Switch to a named preset from the camera 'modes' table, or back to
+        the configured width/height/fps with an empty name."""
+        cam = self._cam_cfg()
+        preset = (cam.get("modes") or {}).get(name) if name else None
+        if name and preset is None:
+            logger.warning("Camera %d: unknown mode '%s'", self._camera_id, name)
+            return
+        src = preset or cam
+        self._mode_name = name if preset else ""
+        self.set_mode(src.get("width", cam.get("width", 1280)),
+                      src.get("height", cam.get("height", 720)),
+                      src.get("fps", cam.get("fps", 90)))
+
+    def set_mode(self, width: int, height: int, fps: int):
+        """Request a sensor mode. The capture thread applies it in place on the
+        open device between two reads - no release/reopen, no thread restart."""
+        with self._lock:
+            self._pending_mode = (int(width), int(height), int(fps))
+
     def register_frame_callback(self, cb: Callable):
-        """Register callback(color, gray, timestamp) for each new frame."""
+        """Register callback(frame) for each new frame. frame is the pooled
+        FrameBuffer (bgr, gray, timestamp, level(n)); valid for the call only,
+        retain() it to keep it longer."""
         self._on_frame_callbacks.append(cb)
 
+    def register_frame_start_callback(self, cb: Callable):
+        """Register callback(timestamp, period) fired as soon as a frame is read,
+        before any conversion; timestamp is the driver's capture time (see
+        _frame_timestamp). Used for exposure-synchronized light strobing."""
+        self._on_frame_start_callbacks.append(cb)
+
     # ------------------------------------------------------------------
     # Settings
     # ------------------------------------------------------------------
@@ -82,8 +174,8 @@ class CameraManager:
         """Apply current config camera settings to the capture device."""
         if self._cap is None or not self._cap.isOpened():
             return
-        cam = self._cfg.get("camera")
-        if cam is None:
+        cam = self._cam_cfg()
+        if not cam:
             return
 
         # Exposure (disable auto first)
@@ -98,27 +190,67 @@ class CameraManager:
         self._cap.set(cv2.CAP_PROP_CONTRAST, cam.get("contrast", 50))
         logger.info("Camera settings applied")
 
-    def get_jpeg_frame(self, quality: int = 70) -> Optional[bytes]:
-        """Return latest frame as JPEG bytes for MJPEG streaming."""
-        with self._lock:
-            frame = self._latest_frame
+    def get_jpeg_frame(self, quality: int = 70, level: int = 0) -> Optional[bytes]:
+        """Return latest frame as JPEG bytes for MJPEG streaming. level 0 is
+        the full color frame; level n > 0 the shared 1/2**n gray pyramid level
+        (far cheaper to encode for a small dashboard view)."""
+        frame = self.acquire_latest()
         if frame is None:
             return None
-        ret, buf = cv2.imencode(".jpg", frame, [cv2.IMWRITE_JPEG_QUALITY, quality])
+        with frame:
+            img = frame.level(level) if level > 0 else frame.bgr
+            ret, buf = cv2.imencode(".jpg", img, [cv2.IMWRITE_JPEG_QUALITY, quality])
         return buf.tobytes() if ret else None
 
     # ------------------------------------------------------------------
     # Internal
     # ------------------------------------------------------------------
 
+    def _cam_cfg(self) -> dict:
+        return self._cfg.camera_section(self._camera_id, "camera")
+
+    def _pin_thread(self):
+        """Pin the capture thread (which also runs detection callbacks) to its
+        cores. With several cameras and no explicit 'cpu_affinity', the cores
+        are split evenly so camera pipelines do not compete for the same CPU."""
+        if not hasattr(os, "sched_setaffinity"):
+            return
+        cores = self._cam_cfg().get("cpu_affinity")
+        n_cams = self._cfg.num_cameras()
+        if not cores and n_cams > 1:
+            ncpu = os.cpu_count() or 1
+            per = max(1, ncpu // n_cams)
+            cores = [(self._camera_id * per + k) % ncpu for k in range(per)]
+        if not cores:
+            return
+        try:
+            # pid 0 = calling thread on Linux
+            os.sched_setaffinity(0, set(int(c) for c in cores))
+            logger.info("Camera %d capture thread pinned to cores %s", self._camera_id, sorted(cores))
+        except (OSError, ValueError) as e:
+            logger.warning("Could not pin camera %d thread: %s", self._camera_id, e)
+
     def _open_camera(self):
-        cam = self._cfg.get("camera")
+        cam = self._cam_cfg()
         device = cam.get("device", "/dev/video0")
-        width = cam.get("width", 1280)
-        height = cam.get("height", 720)
-        fps = cam.get("fps", 90)
+        # Reopen in the active mode, e.g. after a disconnect mid-switch
+        width, height, fps = self._mode or (cam.get("width", 1280), cam.get("height", 720),
+                                            cam.get("fps", 90))
         idx = cam.get("camera_index", 0)
 
+        fake = fake_camera.device_path(device)
+        if fake is not None:
+            cap = fake_camera.FakeCapture(fake, _READ_TIMEOUT_MS / 1000.0)
+            if not cap.isOpened():
+                return None
+            # The writer decides the frame size
+            width = int(cap.get(cv2.CAP_PROP_FRAME_WIDTH))
+            height = int(cap.get(cv2.CAP_PROP_FRAME_HEIGHT))
+            self._mode = (width, height, int(fps))
+            logger.info("Camera %d opened: fake src=%s res=%dx%d", self._camera_id,
+                        fake, width, height)
+            return cap
+
         # Try device path first, fallback to index
         for src in [device, idx]:
             cap = cv2.VideoCapture(src, cv2.CAP_V4L2)
@@ -130,42 +262,174 @@ class CameraManager:
                 cap.set(cv2.CAP_PROP_FOURCC, cv2.VideoWriter_fourcc(*"MJPG"))
                 # Minimize buffer for low latency
                 cap.set(cv2.CAP_PROP_BUFFERSIZE, 1)
-                logger.info("Camera opened: src=%s res=%dx%d fps=%d", src, width, height, fps)
+                # A stalled device should fail the read quickly (backend default
+                # is seconds), not freeze the capture thread
+                if hasattr(cv2, "CAP_PROP_READ_TIMEOUT_MSEC"):
+                    cap.set(cv2.CAP_PROP_READ_TIMEOUT_MSEC, _READ_TIMEOUT_MS)
+                self._mode = (int(width), int(height), int(fps))
+                logger.info("Camera %d opened: src=%s res=%dx%d fps=%d",
+                            self._camera_id, src, width, height, fps)
                 return cap
             cap.release()
 
         logger.error("Failed to open camera")
         return None
 
+    def _switch_mode(self, mode: Tuple[int, int, int]):
+        """Apply a sensor mode on the open capture. The V4L2 backend restarts
+        streaming on the same file descriptor; only if the driver refuses the
+        format in place is the device reopened."""
+        if mode == self._mode:
+            return
+        width, height, fps = mode
+        t0 = time.monotonic()
+        self._cap.set(cv2.CAP_PROP_FRAME_WIDTH, width)
+        self._cap.set(cv2.CAP_PROP_FRAME_HEIGHT, height)
+        self._cap.set(cv2.CAP_PROP_FPS, fps)
+        actual = (int(self._cap.get(cv2.CAP_PROP_FRAME_WIDTH)),
+                  int(self._cap.get(cv2.CAP_PROP_FRAME_HEIGHT)))
+        if actual != (width, height):
+            logger.warning("Camera %d: in-place switch to %dx%d gave %dx%d, reopening",
+                           self._camera_id, width, height, actual[0], actual[1])
+            self._cap.release()
+            self._mode = mode
+            self._cap = self._open_camera()
+            if self._cap:
+                self.apply_settings()
+        self._mode = mode
+        # New frame interval: re-seed the period estimate used for strobing
+        self._frame_period = 1.0 / max(1, fps)
+        self._last_frame_ts = 0.0
+        self._last_switch_ms = (time.monotonic() - t0) * 1000.0
+        logger.info("Camera %d mode %dx%d@%d applied in %.1f ms", self._camera_id,
+                    width, height, fps, self._last_switch_ms)
+
+    def _frame_shape(self) -> Tuple[int, int]:
+        """(height, width) expected from the next read."""
+        latest = self._latest
+        if latest is not None:
+            return latest.shape
+        w, h, _ = self._mode or (1280, 720, 0)
+        return h, w
+
+    def _mark_disconnected(self):
+        if self._lost_at is None and self._mode is not None:
+            self._lost_at = time.monotonic()
+            self._disconnects += 1
+
+    def _mark_recovered(self):
+        """First good frame after a disconnect: record the outage length."""
+        self._last_recovery_ms = (time.monotonic() - self._lost_at) * 1000.0
+        self._lost_at = None
+        self._last_frame_ts = 0.0
+        logger.info("Camera %d recovered in %.0f ms (disconnect #%d)",
+                    self._camera_id, self._last_recovery_ms, self._disconnects)
+
+    def _update_frame_period(self, ts: float):
+        """Track the frame interval with a light EMA (seeded from config fps)."""
+        if self._frame_period <= 0.0:
+            fps = float(self._cam_cfg().get("fps", 90)) or 90.0
+            self._frame_period = 1.0 / fps
+        if self._last_frame_ts > 0.0:
+            dt = ts - self._last_frame_ts
+            # Ignore gaps from dropped frames / reconnects
+            if 0.0 < dt < 3.0 * self._frame_period:
+                self._frame_period += 0.1 * (dt - self._frame_period)
+        self._last_frame_ts = ts
+
+    def _frame_timestamp(self, now: float) -> float:
+        """Capture time of the frame just read, in time.monotonic() seconds:
+        the V4L2 buffer timestamp (CLOCK_MONOTONIC, stamped by the driver as
+        the frame arrives, so decode and scheduling delays are excluded), or
+        the read time when the backend has none (0, a stream position, or a
+        clock other than CLOCK_MONOTONIC)."""
+        try:
+            ts = self._cap.get(cv2.CAP_PROP_POS_MSEC) / 1000.0
+        except Exception:
+            return now
+        return ts if 0.0 <= now - ts < 1.0 else now
+
     def _capture_loop(self):
+        self._pin_thread()
         self._cap = self._open_camera()
         if self._cap:
             self.apply_settings()
         self._fps_t0 = time.monotonic()
         self._frame_count = 0
 
+        # Device node events (udev hotplug) wake the reopen immediately; the
+        # timed retry (0.1 s doubling to 2 s) only covers missed events
+        device = self._cam_cfg().get("device")
+        watcher = DeviceWatcher(fake_camera.device_path(device) or device)
+        retry_delay = 0.1
+        read_failures = 0
         while self._running:
             if self._cap is None or not self._cap.isOpened():
-                logger.warning("Camera not open, retrying in 2s...")
-                time.sleep(2)
+                self._mark_disconnected()
+                if not watcher.exists() or retry_delay > 0.1:
+                    watcher.wait(retry_delay)
+                if not self._running:
+                    break
+                if not watcher.exists():
+                    retry_delay = min(2.0, retry_delay * 2.0)
+                    continue
                 self._cap = self._open_camera()
                 if self._cap:
+                    # Restores exposure/gain; _open_camera restores the active mode
                     self.apply_settings()
+                    retry_delay = 0.1
+                else:
+                    retry_delay = min(2.0, retry_delay * 2.0)
+                continue
+
+            if self._pending_mode is not None:
+                with self._lock:
+                    mode, self._pending_mode = self._pending_mode, None
+                self._switch_mode(mode)
                 continue
 
-            ret, frame = self._cap.read()
+            # Decode straight into a pooled buffer
+            buf = self._pool.acquire(self._frame_shape())
+            ret, frame = self._cap.read(buf.bgr)
             if not ret:
-                logger.warning("Failed to capture frame, retrying...")
-                time.sleep(0.05)
+                buf.release()
+                read_failures += 1
+                # A vanished node (cable pulled) or repeated failures mean the
+                # device is gone: drop it now rather than spinning on read()
+                if not watcher.exists() or read_failures >= _MAX_READ_FAILURES:
+                    logger.warning("Camera %d lost (%s), waiting for it to reappear",
+                                   self._camera_id,
+                                   "device removed" if not watcher.exists() else "read failures")
+                    self._cap.release()
+                    self._cap = None
+                    read_failures = 0
+                else:
+                    time.sleep(0.005)
                 continue
+            read_failures = 0
+            if self._lost_at is not None:
+                self._mark_recovered()
 
-            ts = time.monotonic()
-            gray = cv2.cvtColor(frame, cv2.COLOR_BGR2GRAY)
+            ts = self._frame_timestamp(time.monotonic())
+            self._update_frame_period(ts)
+            for cb in self._on_frame_start_callbacks:
+                try:
+                    cb(ts, self._frame_period)
+                except Exception as e:
+                    logger.warning("Frame start callback error: %s", e)
+
+            if frame is not buf.bgr:
+                # Frame size changed (mode switch): the pool follows the new size
+                buf.release()
+                buf = self._pool.acquire(frame.shape[:2])
+                np.copyto(buf.bgr, frame)
+            cv2.cvtColor(buf.bgr, cv2.COLOR_BGR2GRAY, dst=buf.gray)
+            buf.timestamp = ts
 
             with self._lock:
-                self._latest_frame = frame
-                self._latest_gray = gray
-                self._frame_time = ts
+                prev, self._latest = self._latest, buf
+            if prev is not None:
+                prev.release()
 
             # FPS calculation
             self._frame_count += 1
@@ -178,10 +442,15 @@ class CameraManager:
             # Fire callbacks
             for cb in self._on_frame_callbacks:
                 try:
-                    cb(frame, gray, ts)
+                    cb(buf)
                 except Exception as e:
                     logger.warning("Frame callback error: %s", e)
 
+        watcher.close()
+        with self._lock:
+            prev, self._latest = self._latest, None
+        if prev is not None:
+            prev.release()
         if self._cap:
             self._cap.release()
             self._cap = None
@@ -66,6 +66,30 @@ class ConfigManager:
         with self._lock:
             return copy.deepcopy(self._config)
 
+    def num_cameras(self) -> int:
+        """Number of configured cameras. Without a 'cameras' list the legacy
+        single 'camera' section counts as one camera."""
+        cams = self.get("cameras")
+        if isinstance(cams, list) and cams:
+            return len(cams)
+        return 1
+
+    def camera_section(self, index: int, section: str = "camera") -> dict:
+        """Return the per-camera view of 'camera', 'camera_mount' or 'calibration'.
+        Entries of the optional 'cameras' list override the top-level section:
+        plain keys override 'camera', nested dicts override the named section."""
+        base = self.get(section) or {}
+        cams = self.get("cameras")
+        if not isinstance(cams, list) or index >= len(cams) or not isinstance(cams[index], dict):
+            return base
+        entry = cams[index]
+        if section == "camera":
+            override = {k: v for k, v in entry.items() if not isinstance(v, dict)}
+        else:
+            override = entry.get(section) or {}
+        base.update(override)
+        return base
+
     def register_callback(self, cb):
         """Register a callback(keys: list, value) called on any change."""
         self._callbacks.append(cb)
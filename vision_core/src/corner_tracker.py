@@ -0,0 +1,221 @@
+"""
+XNav Corner Tracker
+
+Keeps tag poses updating at the full camera rate while the AprilTag
+detector runs only on every Nth frame. In between, the four corners of each
+tag from the last frame are followed into the new frame with sparse
+pyramidal Lucas-Kanade optical flow, checked forward-backward, and handed to
+the detector's pose solver like a fresh detection.
+
+Each full detection validates the tracks: the tracked corners for that frame
+are compared with the detected ones, and on any disagreement beyond
+`validate_max_px` full detection runs on every frame until the tracks agree
+again. Tracks also expire after `max_track_age_s` and are dropped when the
+flow for any corner fails, so new tags are always found by a full detection.
+"""
+
+import threading
+import logging
+import cv2
+import numpy as np
+from typing import Optional
+
+from apriltag_detector import DetectionBatch
+
+logger = logging.getLogger(__name__)
+
+# Tracked quads smaller than this (pixels^2) are dropped
+_MIN_QUAD_AREA = 64.0
+
+
+def _quad_area(corners: np.ndarray) -> np.ndarray:
+    """Signed shoelace area of each (N, 4, 2) quad."""
+    x, y = corners[..., 0], corners[..., 1]
+    return 0.5 * np.sum(x * np.roll(y, -1, axis=-1) - np.roll(x, -1, axis=-1) * y, axis=-1)
+
+
+def _diagonal_center(corners: np.ndarray) -> np.ndarray:
+    """Intersection of each quad's diagonals (the projected tag center, as
+    the detector reports it)."""
+    p0, p1, p2, p3 = (corners[:, k] for k in range(4))
+    d1, d2 = p2 - p0, p3 - p1
+    den = d1[:, 0] * d2[:, 1] - d1[:, 1] * d2[:, 0]
+    r = p1 - p0
+    s = np.divide(r[:, 0] * d2[:, 1] - r[:, 1] * d2[:, 0], den,
+                  out=np.full(len(den), 0.5), where=np.abs(den) > 1e-9)
+    return p0 + s[:, None] * d1
+
+
+class CornerTracker:
+    """Per-camera detect-every-N / track-in-between policy."""
+
+    def __init__(self, cfg, camera_id: int = 0):
+        self._cfg = cfg
+        self._camera_id = camera_id
+        self._lock = threading.Lock()
+        # Previous frame (copied: pooled buffers are reused) and its tags
+        self._prev: Optional[np.ndarray] = None
+        self._tags: Optional[DetectionBatch] = None
+        self._detected_ts = 0.0
+        self._since_detect = 0
+        self._validated = True
+        # Stats for the dashboard
+        self._tracked_frames = 0
+        self._detected_frames = 0
+        self._validations = 0
+        self._failures = 0
+        self._last_error_px = 0.0
+
+    def enabled(self) -> bool:
+        return bool((self._cfg.get("corner_tracking") or {}).get("enabled", False))
+
+    def detection_due(self, frame) -> bool:
+        """True when this frame needs a full detection."""
+        tcfg = self._cfg.get("corner_tracking") or {}
+        if self._tags is None or not len(self._tags) or not self._validated:
+            return True
+        if self._prev is None or self._prev.shape != frame.gray.shape:
+            return True
+        if frame.timestamp - self._detected_ts > float(tcfg.get("max_track_age_s", 0.25)):
+            return True
+        return self._since_detect + 1 >= max(1, int(tcfg.get("detect_interval", 3)))
+
+    def track(self, frame) -> Optional[DetectionBatch]:
+        """Corners of the last frame's tags followed into this frame (angles
+        and poses not yet solved), or None when every track was lost."""
+        corners = self._flow(frame.gray)
+        self._remember(frame.gray)
+        if corners is None:
+            self._tags = None
+            return None
+        ok = ~np.isnan(corners).any(axis=(1, 2))
+        if not ok.any():
+            self._tags = None
+            return None
+        batch = self._tags.select(ok)
+        batch.timestamp = frame.timestamp
+        batch.corners = corners[ok]
+        batch.center = _diagonal_center(batch.corners)
+        self._reset_solution(batch)
+        self._tags = batch
+        self._since_detect += 1
+        with self._lock:
+            self._tracked_frames += 1
+        return batch
+
+    def detected(self, frame, batch: DetectionBatch):
+        """Full detection on this frame: validate the tracks against it and
+        restart tracking from the detected corners."""
+        if self._tags is not None and len(self._tags) and len(batch) and self._prev is not None \
+                and self._prev.shape == frame.gray.shape:
+            self._validate(frame.gray, batch)
+        self._remember(frame.gray)
+        self._tags = batch.select(np.arange(len(batch)))
+        self._detected_ts = frame.timestamp
+        self._since_detect = 0
+        with self._lock:
+            self._detected_frames += 1
+
+    def get_status(self) -> dict:
+        with self._lock:
+            total = self._tracked_frames + self._detected_frames
+            return {
+                "tracked_frames": self._tracked_frames,
+                "detected_frames": self._detected_frames,
+                "tracked_fraction": round(self._tracked_frames / total, 3) if total else 0.0,
+                "validations": self._validations,
+                "validation_failures": self._failures,
+                "last_error_px": round(self._last_error_px, 2),
+                "validated": self._validated,
+            }
+
+    # ------------------------------------------------------------------
+    # Internal
+    # ------------------------------------------------------------------
+
+    def _remember(self, gray: np.ndarray):
+        if self._prev is None or self._prev.shape != gray.shape:
+            self._prev = np.empty_like(gray)
+        np.copyto(self._prev, gray)
+
+    def _flow(self, gray: np.ndarray) -> Optional[np.ndarray]:
+        """(N, 4, 2) corners in this frame, NaN rows for lost tags."""
+        if self._tags is None or not len(self._tags) or self._prev is None \
+                or self._prev.shape != gray.shape:
+            return None
+        tcfg = self._cfg.get("corner_tracking") or {}
+        win = int(tcfg.get("win_size", 15))
+        level = int(tcfg.get("max_level", 2))
+        params = dict(winSize=(win, win), maxLevel=level,
+                      criteria=(cv2.TERM_CRITERIA_EPS | cv2.TERM_CRITERIA_COUNT, 20, 0.03))
+        max_fb = float(tcfg.get("max_fb_error_px", 0.75))
+        # Flow runs in a window around each tag (views, no copies): the full
+        # frame pyramids would cost several times the flow itself. The margin
+        # covers the largest motion the pyramid can follow.
+        margin = win * (1 << level)
+        h, w = gray.shape[:2]
+        corners = np.full(self._tags.corners.shape, np.nan)
+        good = np.zeros(corners.shape[:2], dtype=bool)
+        for row, quad in enumerate(self._tags.corners):
+            x0, y0 = np.maximum(np.floor(quad.min(axis=0)).astype(int) - margin, 0)
+            x1, y1 = np.minimum(np.ceil(quad.max(axis=0)).astype(int) + margin, [w, h])
+            if x1 - x0 < win or y1 - y0 < win:
+                continue
+            p0 = (quad - [x0, y0]).reshape(-1, 1, 2).astype(np.float32)
+            prev_win, cur_win = self._prev[y0:y1, x0:x1], gray[y0:y1, x0:x1]
+            try:
+                p1, st1, _ = cv2.calcOpticalFlowPyrLK(prev_win, cur_win, p0, None, **params)
+                # Backward check: flowing the result back must land on the start
+                pb, st2, _ = cv2.calcOpticalFlowPyrLK(cur_win, prev_win, p1, None, **params)
+            except cv2.error as e:
+                logger.debug("Corner flow failed: %s", e)
+                continue
+            fb = np.linalg.norm((pb - p0).reshape(-1, 2), axis=1)
+            good[row] = (st1.ravel() == 1) & (st2.ravel() == 1) & (fb <= max_fb)
+            corners[row] = p1.reshape(4, 2) + [x0, y0]
+        inside = ((corners >= 0) & (corners < [w, h])).all(axis=2)
+        good &= inside
+        # Keep the winding of the detected quad and a usable size
+        area = _quad_area(corners)
+        same_winding = np.sign(area) == np.sign(_quad_area(self._tags.corners))
+        keep = good.all(axis=1) & same_winding & (np.abs(area) >= _MIN_QUAD_AREA)
+        corners[~keep] = np.nan
+        return corners
+
+    def _validate(self, gray: np.ndarray, detected: DetectionBatch):
+        """Compare tracked corners for this frame with the detection."""
+        tracked = self._flow(gray)
+        if tracked is None:
+            return
+        tcfg = self._cfg.get("corner_tracking") or {}
+        limit = float(tcfg.get("validate_max_px", 2.0))
+        worst = 0.0
+        compared = False
+        for row, tag_id in enumerate(self._tags.ids):
+            match = np.flatnonzero(detected.ids == tag_id)
+            if not len(match) or np.isnan(tracked[row]).any():
+                continue
+            err = float(np.max(np.linalg.norm(tracked[row] - detected.corners[match[0]], axis=1)))
+            worst = max(worst, err)
+            compared = True
+        if not compared:
+            return
+        ok = worst <= limit
+        if ok != self._validated:
+            logger.info("Camera %d corner tracks %s (max error %.1f px)", self._camera_id,
+                        "validated - tracking resumed" if ok else
+                        "drifted - detecting every frame", worst)
+        self._validated = ok
+        with self._lock:
+            self._validations += 1
+            self._failures += 0 if ok else 1
+            self._last_error_px = worst
+
+    @staticmethod
+    def _reset_solution(batch: DetectionBatch):
+        """Clear the pose carried over from the seed detection."""
+        batch.has_pose[:] = False
+        batch.has_alt[:] = False
+        batch.ambiguity[:] = 0.0
+        batch.reproj_error[:] = 0.0
+        batch.distance[:] = 0.0
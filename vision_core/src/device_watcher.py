@@ -0,0 +1,116 @@
+"""
+XNav Device Watcher
+
+Wakes the camera capture thread as soon as its video device node is created
+or changes (udev creates /dev/videoN, then fixes its permissions), instead of
+polling on a fixed interval. Uses Linux inotify through libc, so no extra
+dependency; falls back to short polling where inotify is unavailable.
+"""
+
+import os
+import time
+import select
+import struct
+import ctypes
+import ctypes.util
+import logging
+from typing import Optional
+
+logger = logging.getLogger(__name__)
+
+_IN_ATTRIB = 0x00000004
+_IN_CREATE = 0x00000100
+_IN_DELETE = 0x00000200
+_IN_MOVED_TO = 0x00000080
+_IN_NONBLOCK = 0o4000
+_IN_CLOEXEC = 0o2000000
+_EVENT_HDR = struct.Struct("iIII")
+
+# Without inotify, how often to check for the device node
+_POLL_INTERVAL = 0.05
+
+try:
+    _libc = ctypes.CDLL(ctypes.util.find_library("c") or "libc.so.6", use_errno=True)
+    _libc.inotify_init1.argtypes = [ctypes.c_int]
+    _libc.inotify_add_watch.argtypes = [ctypes.c_int, ctypes.c_char_p, ctypes.c_uint32]
+    _INOTIFY_AVAILABLE = True
+except (OSError, AttributeError):
+    _libc = None
+    _INOTIFY_AVAILABLE = False
+
+
+class DeviceWatcher:
+    """Waits for a device node (e.g. /dev/video0) to appear or change."""
+
+    def __init__(self, device_path: Optional[str]):
+        self._path = device_path if isinstance(device_path, str) else None
+        self._name = os.path.basename(self._path).encode() if self._path else b""
+        self._fd = -1
+        if self._path and _INOTIFY_AVAILABLE:
+            self._open()
+
+    def _open(self):
+        # Watch the directory: the node itself does not exist while unplugged
+        watch_dir = os.path.dirname(self._path) or "/dev"
+        if not os.path.isdir(watch_dir):
+            watch_dir = "/dev"
+        fd = _libc.inotify_init1(_IN_NONBLOCK | _IN_CLOEXEC)
+        if fd < 0:
+            logger.debug("inotify_init1 failed: errno %d", ctypes.get_errno())
+            return
+        mask = _IN_CREATE | _IN_ATTRIB | _IN_DELETE | _IN_MOVED_TO
+        if _libc.inotify_add_watch(fd, watch_dir.encode(), mask) < 0:
+            logger.debug("inotify watch on %s failed: errno %d", watch_dir, ctypes.get_errno())
+            os.close(fd)
+            return
+        self._fd = fd
+        logger.debug("Watching %s for %s", watch_dir, self._path)
+
+    def exists(self) -> bool:
+        """True if the device node is present (always True for index sources)."""
+        return self._path is None or os.path.exists(self._path)
+
+    def wait(self, timeout: float) -> bool:
+        """Block until the device node is created or changed, or timeout.
+        Returns True if it (probably) changed, False on timeout."""
+        if self._path is None:
+            time.sleep(timeout)
+            return False
+        if self._fd < 0:
+            # Polling fallback: report as soon as the node is present
+            deadline = time.monotonic() + timeout
+            while time.monotonic() < deadline:
+                if os.path.exists(self._path):
+                    return True
+                time.sleep(_POLL_INTERVAL)
+            return False
+
+        deadline = time.monotonic() + timeout
+        while True:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                return False
+            ready, _, _ = select.select([self._fd], [], [], remaining)
+            if ready and self._drain():
+                return True
+
+    def _drain(self) -> bool:
+        """Consume pending events; True if any concerned our device."""
+        try:
+            buf = os.read(self._fd, 4096)
+        except BlockingIOError:
+            return False
+        hit = False
+        off = 0
+        while off + _EVENT_HDR.size <= len(buf):
+            _wd, mask, _cookie, length = _EVENT_HDR.unpack_from(buf, off)
+            name = buf[off + _EVENT_HDR.size:off + _EVENT_HDR.size + length].rstrip(b"\0")
+            off += _EVENT_HDR.size + length
+            if name == self._name and not mask & _IN_DELETE:
+                hit = True
+        return hit
+
+    def close(self):
+        if self._fd >= 0:
+            os.close(self._fd)
+            self._fd = -1
@@ -0,0 +1,141 @@
+"""
+XNav Fake Camera
+
+A file-backed camera for testing the pipeline without hardware. A writer
+(e.g. the latency rig in vision_core/tools) publishes gray frames into a
+memory-mapped file, usually under /dev/shm; CameraManager reads them through
+FakeCapture, which has the subset of the cv2.VideoCapture interface the
+capture loop uses. Select it with a camera device of "shm:<path>".
+
+File layout: a 64-byte header (magic, width, height, sequence, timestamp)
+followed by one width*height gray frame. The sequence is odd while the
+writer is copying a frame in (seqlock), so a reader never returns a torn
+frame.
+"""
+
+import os
+import mmap
+import time
+import struct
+import logging
+import cv2
+import numpy as np
+from typing import Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+DEVICE_PREFIX = "shm:"
+
+_MAGIC = b"XNFC"
+_HEADER = struct.Struct("<4sIIIQd")    # magic, width, height, reserved, seq, timestamp
+_SEQ_OFFSET = 16
+_DATA_OFFSET = 64
+# How often the reader checks for a new frame while waiting
+_POLL_INTERVAL = 0.0005
+
+
+def device_path(device) -> Optional[str]:
+    """File path of a "shm:<path>" camera device, else None."""
+    if isinstance(device, str) and device.startswith(DEVICE_PREFIX):
+        return device[len(DEVICE_PREFIX):]
+    return None
+
+
+class FakeFrameWriter:
+    """Producer side: publishes frames into the shared file."""
+
+    def __init__(self, path: str, width: int, height: int):
+        self.width, self.height = int(width), int(height)
+        size = _DATA_OFFSET + self.width * self.height
+        fd = os.open(path, os.O_RDWR | os.O_CREAT, 0o644)
+        try:
+            os.ftruncate(fd, size)
+            self._mm = mmap.mmap(fd, size)
+        finally:
+            os.close(fd)
+        self._seq = 0
+        self._data = np.frombuffer(self._mm, dtype=np.uint8, count=self.width * self.height,
+                                   offset=_DATA_OFFSET).reshape(self.height, self.width)
+        _HEADER.pack_into(self._mm, 0, _MAGIC, self.width, self.height, 0, self._seq, 0.0)
+
+    def write(self, gray: np.ndarray) -> float:
+        """Publish one frame; returns the time.monotonic() it became visible."""
+        self._seq += 1
+        struct.pack_into("<Q", self._mm, _SEQ_OFFSET, self._seq)        # odd: writing
+        np.copyto(self._data, gray)
+        self._seq += 1
+        ts = time.monotonic()
+        _HEADER.pack_into(self._mm, 0, _MAGIC, self.width, self.height, 0, self._seq, ts)
+        return ts
+
+    def close(self):
+        self._data = None
+        self._mm.close()
+
+
+class FakeCapture:
+    """Consumer side: a minimal cv2.VideoCapture stand-in over the shared file."""
+
+    def __init__(self, path: str, read_timeout_s: float = 0.5):
+        self._path = path
+        self._timeout = read_timeout_s
+        self._mm: Optional[mmap.mmap] = None
+        self._size: Tuple[int, int] = (0, 0)
+        self._last_seq = 0
+        try:
+            fd = os.open(path, os.O_RDONLY)
+            try:
+                self._mm = mmap.mmap(fd, 0, access=mmap.ACCESS_READ)
+            finally:
+                os.close(fd)
+        except (OSError, ValueError) as e:
+            logger.debug("Fake camera %s unavailable: %s", path, e)
+            return
+        magic, width, height, _, seq, _ = _HEADER.unpack_from(self._mm, 0)
+        if magic != _MAGIC or len(self._mm) < _DATA_OFFSET + width * height:
+            logger.warning("Fake camera %s: not a frame file", path)
+            self.release()
+            return
+        self._size = (width, height)
+        self._last_seq = seq
+
+    def isOpened(self) -> bool:
+        return self._mm is not None
+
+    def read(self, dst: Optional[np.ndarray] = None):
+        """Block until the writer publishes a new frame (or timeout)."""
+        if self._mm is None:
+            return False, None
+        width, height = self._size
+        deadline = time.monotonic() + self._timeout
+        while True:
+            seq = _HEADER.unpack_from(self._mm, 0)[4]
+            if seq != self._last_seq and not seq & 1:
+                gray = np.frombuffer(self._mm, dtype=np.uint8, count=width * height,
+                                     offset=_DATA_OFFSET).reshape(height, width)
+                use_dst = dst is not None and dst.shape == (height, width, 3)
+                frame = cv2.cvtColor(gray, cv2.COLOR_GRAY2BGR, dst=dst if use_dst else None)
+                # Discard if the writer started the next frame during the copy
+                if _HEADER.unpack_from(self._mm, 0)[4] == seq:
+                    self._last_seq = seq
+                    return True, frame
+                continue
+            if time.monotonic() >= deadline or not os.path.exists(self._path):
+                return False, None
+            time.sleep(_POLL_INTERVAL)
+
+    def get(self, prop: int) -> float:
+        if prop == cv2.CAP_PROP_FRAME_WIDTH:
+            return float(self._size[0])
+        if prop == cv2.CAP_PROP_FRAME_HEIGHT:
+            return float(self._size[1])
+        return 0.0
+
+    def set(self, prop: int, value) -> bool:
+        # Size and rate are decided by the writer
+        return False
+
+    def release(self):
+        if self._mm is not None:
+            self._mm.close()
+            self._mm = None
@@ -0,0 +1,57 @@
+"""
+XNav Frame Deadline
+
+Bounds the age of published results. Each processed frame gets a deadline
+`budget_frames` frame periods after its capture, checked only before the
+expensive stages: AprilTag detection, each ROI window and the calibration
+board search. Once the deadline has passed and the camera's next frame is
+already waiting (capture runs with a one-frame driver queue, so the newest
+frame is the one read next), starting that work would only publish a stale
+result late and delay the fresh one: the stage raises FrameAbandoned and the
+pipeline moves on to the newer frame. Once detection has finished, the frame
+is solved and published; the pose solves are cheap next to the work already
+done.
+
+Abandoning is bounded: after `max_consecutive` abandoned frames in a row,
+the next frame runs without a deadline, so a scene that is always over
+budget still publishes.
+"""
+
+import math
+import time
+
+
+class FrameAbandoned(Exception):
+    """A frame's deadline passed with a newer frame waiting (carries the stage)."""
+
+    def __init__(self, stage: str):
+        super().__init__(stage)
+        self.stage = stage
+
+
+class FrameDeadline:
+    """Deadline of one frame, in time.monotonic() seconds. The budget is at
+    least one frame period, so past the deadline a newer frame is waiting."""
+
+    __slots__ = ("expires",)
+
+    def __init__(self, expires: float = math.inf):
+        self.expires = expires
+
+    @classmethod
+    def for_frame(cls, timestamp: float, period: float, budget_frames: float) -> "FrameDeadline":
+        if period <= 0.0:
+            return NO_DEADLINE
+        return cls(timestamp + max(1.0, budget_frames) * period)
+
+    def expired(self) -> bool:
+        return self.expires != math.inf and time.monotonic() >= self.expires
+
+    def check(self, stage: str):
+        """Safe point: raise FrameAbandoned if the frame is past its deadline."""
+        if self.expired():
+            raise FrameAbandoned(stage)
+
+
+# Shared default for callers without a deadline (tools, the dashboard)
+NO_DEADLINE = FrameDeadline()
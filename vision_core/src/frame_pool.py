@@ -0,0 +1,134 @@
+"""
+XNav Frame Pool
+
+A small ring of preallocated BGR + gray frame buffers. The capture thread
+decodes and converts into a free buffer (OpenCV dst= outputs) instead of
+allocating two new arrays per frame; consumers get the buffer by reference
+and hold it with retain()/release(). A buffer returns to the pool when its
+last holder releases it, so a slow reader (e.g. the MJPEG stream) can never
+see a frame being overwritten underneath it.
+
+Each buffer also carries a gray pyramid (full, 1/2, 1/4) built lazily: a
+level is computed the first time any consumer asks for it in that frame and
+then shared, so detection, the motion gate, calibration and the dashboard
+never convert or downsample the same frame twice.
+"""
+
+import threading
+import logging
+import cv2
+import numpy as np
+from typing import List, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+# Gray pyramid depth: level 0 = full size, level n = 1/2**n
+PYRAMID_LEVELS = 3
+
+
+class FrameBuffer:
+    """One pooled frame: color image, its gray conversion and a timestamp."""
+
+    __slots__ = ("bgr", "gray", "timestamp", "_pool", "_refs",
+                 "_levels", "_built", "_level_lock")
+
+    def __init__(self, pool: "FramePool", shape: Tuple[int, int]):
+        h, w = shape
+        self.bgr = np.empty((h, w, 3), dtype=np.uint8)
+        self.gray = np.empty((h, w), dtype=np.uint8)
+        self.timestamp = 0.0
+        self._pool = pool
+        self._refs = 0
+        # Level arrays are allocated once per buffer and refilled per frame
+        self._levels: List[np.ndarray] = [self.gray]
+        self._built = 1
+        self._level_lock = threading.Lock()
+
+    @property
+    def shape(self) -> Tuple[int, int]:
+        return self.gray.shape
+
+    def level(self, n: int) -> np.ndarray:
+        """Gray image at 1/2**n size (0 = full). Built on first request for
+        this frame by a 2x2 area average of the level above, then cached."""
+        n = max(0, min(int(n), PYRAMID_LEVELS - 1))
+        if n < self._built:
+            return self._levels[n]
+        with self._level_lock:
+            while self._built <= n:
+                src = self._levels[self._built - 1]
+                size = (src.shape[1] // 2, src.shape[0] // 2)
+                if len(self._levels) <= self._built:
+                    self._levels.append(np.empty((size[1], size[0]), dtype=np.uint8))
+                dst = self._levels[self._built]
+                if dst.shape != (size[1], size[0]):
+                    dst = self._levels[self._built] = np.empty((size[1], size[0]), dtype=np.uint8)
+                cv2.resize(src, size, dst=dst, interpolation=cv2.INTER_AREA)
+                self._built += 1
+        return self._levels[n]
+
+    def level_for_width(self, min_width: int) -> int:
+        """Smallest pyramid level that is still at least min_width wide."""
+        n = 0
+        while n + 1 < PYRAMID_LEVELS and (self.gray.shape[1] >> (n + 1)) >= min_width:
+            n += 1
+        return n
+
+    def retain(self) -> "FrameBuffer":
+        with self._pool._lock:
+            self._refs += 1
+        return self
+
+    def release(self):
+        self._pool._release(self)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.release()
+
+
+class FramePool:
+    """Fixed set of reference-counted frame buffers for one frame size."""
+
+    def __init__(self, size: int = 4):
+        self._lock = threading.Lock()
+        self._size = max(2, int(size))
+        self._shape: Optional[Tuple[int, int]] = None
+        self._free: List[FrameBuffer] = []
+        self._overflow = 0
+
+    def acquire(self, shape: Tuple[int, int]) -> FrameBuffer:
+        """A free buffer of (height, width) with one reference. A size change
+        (mode switch) retires the old buffers as they are released. If every
+        buffer is held, a one-off buffer is allocated rather than blocking."""
+        with self._lock:
+            if shape != self._shape:
+                self._shape = shape
+                self._free = [FrameBuffer(self, shape) for _ in range(self._size)]
+                logger.debug("Frame pool: %d buffers of %dx%d", self._size, shape[1], shape[0])
+            if self._free:
+                buf = self._free.pop()
+            else:
+                self._overflow += 1
+                buf = FrameBuffer(self, shape)
+                if self._overflow in (1, 100, 10000):
+                    logger.warning("Frame pool exhausted (%d times); consumers are holding frames",
+                                   self._overflow)
+            buf._refs = 1
+            buf._built = 1    # new frame: only the full-size gray is valid
+            return buf
+
+    def _release(self, buf: FrameBuffer):
+        with self._lock:
+            buf._refs -= 1
+            if buf._refs > 0:
+                return
+            # Recycle only buffers of the current size, up to the pool size
+            if buf.shape == self._shape and len(self._free) < self._size:
+                self._free.append(buf)
+
+    @property
+    def overflow_count(self) -> int:
+        return self._overflow
@@ -1,10 +1,30 @@
 """
 XNav Lights Manager
 Controls LED lights via GPIO on Raspberry Pi CM.
+
+Output backends (lights.backend):
+  hardware_pwm  the SoC's PWM peripheral through /sys/class/pwm - no CPU
+                cost, no jitter (needs the pwm overlay on the pin)
+  rpi_gpio      RPi.GPIO software PWM (a thread toggling the pin at 1 kHz)
+  file          the sysfs PWM layout under a plain directory, for desktop
+                testing of the hardware PWM path
+  simulation    in-memory output history
+  auto          hardware_pwm when the PWM chip is present, else rpi_gpio,
+                else simulation
+
+Modes:
+  on      constant PWM at the configured brightness
+  off     LEDs dark
+  blink   reserved (currently behaves like 'on')
+  strobe  LEDs pulse only while the sensor is exposing, timed from the
+          camera's frame-start notifications (see CameraManager)
 """
 
+import os
 import logging
 import threading
+import time
+from typing import List, Optional, Tuple
 
 logger = logging.getLogger(__name__)
 
@@ -15,18 +35,166 @@ except (ImportError, RuntimeError):
     _GPIO_AVAILABLE = False
     GPIO = None
 
+# V4L2 exposure_absolute is expressed in units of 100 µs
+_V4L2_EXPOSURE_UNIT_S = 100e-6
+
+_SYSFS_PWM_ROOT = "/sys/class/pwm"
+# BCM2711 PWM channel of each PWM-capable header pin (ALT0 / ALT5)
+_PWM_CHANNELS = {12: 0, 18: 0, 13: 1, 19: 1}
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+# Output backends
+# ─────────────────────────────────────────────────────────────────────────────
+
+class _RPiGPIOBackend:
+    """RPi.GPIO output: 1 kHz software PWM, or direct pin drive for strobing."""
+
+    name = "rpi_gpio"
+
+    def __init__(self, pin: int):
+        self._pin = pin
+        GPIO.setmode(GPIO.BCM)
+        GPIO.setwarnings(False)
+        GPIO.setup(pin, GPIO.OUT)
+        self._pwm = GPIO.PWM(pin, 1000)  # 1kHz PWM
+        self._pwm.start(0)
+        self._pwm_running = True
+
+    def set_duty(self, duty: float):
+        if not self._pwm_running:
+            self._pwm.start(duty)
+            self._pwm_running = True
+        else:
+            self._pwm.ChangeDutyCycle(duty)
+
+    def set_level(self, on: bool):
+        # PWM must be stopped first, otherwise its thread keeps toggling the pin
+        if self._pwm_running:
+            self._pwm.stop()
+            self._pwm_running = False
+        GPIO.output(self._pin, GPIO.HIGH if on else GPIO.LOW)
+
+    def cleanup(self):
+        if self._pwm_running:
+            self._pwm.stop()
+        GPIO.cleanup(self._pin)
+
+
+class _SysfsPWMBackend:
+    """Hardware PWM through the kernel's sysfs PWM interface. The waveform
+    is generated by the PWM peripheral; a duty change (or a strobe edge,
+    driven as 0 / 100 % duty) is one pwrite() to duty_cycle.
+
+    With simulate=True the same layout is created as plain files under
+    root, so the hardware path can be exercised on a desktop."""
+
+    def __init__(self, root: str, chip: int, channel: int, frequency_hz: float,
+                 simulate: bool = False):
+        self.name = "file" if simulate else "hardware_pwm"
+        chip_dir = os.path.join(root, f"pwmchip{chip}")
+        self._dir = os.path.join(chip_dir, f"pwm{channel}")
+        self._chip_dir = chip_dir
+        self._channel = channel
+        self._simulate = simulate
+        if simulate:
+            os.makedirs(self._dir, exist_ok=True)
+            for attr in ("period", "duty_cycle", "enable"):
+                with open(os.path.join(self._dir, attr), "w") as f:
+                    f.write("0\n")
+        elif not os.path.isdir(self._dir):
+            with open(os.path.join(chip_dir, "export"), "w") as f:
+                f.write(str(channel))
+            # udev applies attribute permissions shortly after the export
+            deadline = time.monotonic() + 1.0
+            while not os.access(os.path.join(self._dir, "duty_cycle"), os.W_OK):
+                if time.monotonic() > deadline:
+                    raise OSError(f"{self._dir} not writable after export")
+                time.sleep(0.01)
+        self._period_ns = int(round(1e9 / max(1.0, float(frequency_hz))))
+        # Duty first: the kernel rejects a period shorter than the current duty
+        self._write("duty_cycle", 0)
+        self._write("period", self._period_ns)
+        self._write("enable", 1)
+        self._duty_fd = os.open(os.path.join(self._dir, "duty_cycle"), os.O_WRONLY)
+        self._duty_ns = 0
+
+    def set_duty(self, duty: float):
+        ns = int(self._period_ns * max(0.0, min(100.0, float(duty))) / 100.0)
+        if ns != self._duty_ns:
+            data = b"%d\n" % ns
+            os.pwrite(self._duty_fd, data, 0)
+            if self._simulate:
+                os.ftruncate(self._duty_fd, len(data))
+            self._duty_ns = ns
+
+    def set_level(self, on: bool):
+        self.set_duty(100.0 if on else 0.0)
+
+    def cleanup(self):
+        self.set_duty(0.0)
+        os.close(self._duty_fd)
+        self._write("enable", 0)
+        if not self._simulate:
+            with open(os.path.join(self._chip_dir, "unexport"), "w") as f:
+                f.write(str(self._channel))
+
+    def _write(self, attr: str, value: int):
+        with open(os.path.join(self._dir, attr), "w") as f:
+            f.write(f"{value}\n")
+
+
+class _SimGPIOBackend:
+    """In-memory GPIO stand-in for desktop runs; records every output change."""
+
+    name = "simulation"
+
+    def __init__(self, pin: int, history: int = 4096):
+        self._pin = pin
+        self._history = history
+        self._lock = threading.Lock()
+        self.duty: float = 0.0
+        # (monotonic time, duty 0-100) per output change
+        self.events: List[Tuple[float, float]] = []
+
+    def set_duty(self, duty: float):
+        self._record(float(duty))
+
+    def set_level(self, on: bool):
+        self._record(100.0 if on else 0.0)
+
+    def cleanup(self):
+        self._record(0.0)
+
+    def _record(self, duty: float):
+        with self._lock:
+            self.duty = duty
+            self.events.append((time.monotonic(), duty))
+            if len(self.events) > self._history:
+                del self.events[:len(self.events) - self._history]
+
 
 class LightsManager:
     """Controls LED ring light via GPIO PWM."""
 
     def __init__(self, config_manager):
         self._cfg = config_manager
-        self._pwm = None
+        self._backend = None
         self._pin: int = 18
         self._enabled: bool = True
         self._brightness: int = 100
         self._mode: str = "on"
         self._lock = threading.Lock()
+
+        # Strobe scheduling (driven by camera frame-start notifications)
+        self._strobe_cond = threading.Condition()
+        self._strobe_frame_ts: float = 0.0
+        self._strobe_period: float = 0.0
+        self._strobe_seq: int = 0
+        self._strobe_thread: Optional[threading.Thread] = None
+        self._strobe_running = False
+        self._strobe_pulses: int = 0
+
         self._init()
 
     def _init(self):
@@ -36,20 +204,44 @@ class LightsManager:
         self._brightness = int(lights.get("brightness", 100))
         self._mode = str(lights.get("mode", "on"))
 
-        if not _GPIO_AVAILABLE:
-            logger.warning("RPi.GPIO not available - light control disabled (simulation mode)")
-            return
-
         try:
-            GPIO.setmode(GPIO.BCM)
-            GPIO.setwarnings(False)
-            GPIO.setup(self._pin, GPIO.OUT)
-            self._pwm = GPIO.PWM(self._pin, 1000)  # 1kHz PWM
-            self._pwm.start(0)
-            self._apply()
-            logger.info("Lights initialized on GPIO pin %d", self._pin)
+            self._backend = self._create_backend(lights)
         except Exception as e:
             logger.error("Failed to init lights: %s", e)
+            return
+        if self._backend is not None:
+            self._apply()
+
+    def _create_backend(self, lights: dict):
+        """Backend for lights.backend; None when the requested one failed."""
+        kind = str(lights.get("backend", "auto"))
+        chip = int(lights.get("pwm_chip", 0))
+        channel = int(lights.get("pwm_channel", _PWM_CHANNELS.get(self._pin, 0)))
+        freq = float(lights.get("pwm_frequency_hz", 1000))
+        if kind == "file":
+            root = str(lights.get("sim_path", "/tmp/xnav_pwm"))
+            backend = _SysfsPWMBackend(root, chip, channel, freq, simulate=True)
+            logger.info("Lights: file-backed PWM under %s", root)
+            return backend
+        if kind == "simulation":
+            return _SimGPIOBackend(self._pin)
+
+        hw_present = os.path.isdir(os.path.join(_SYSFS_PWM_ROOT, f"pwmchip{chip}"))
+        if kind == "hardware_pwm" or (kind == "auto" and hw_present):
+            try:
+                backend = _SysfsPWMBackend(_SYSFS_PWM_ROOT, chip, channel, freq)
+                logger.info("Lights initialized on hardware PWM (pwmchip%d channel %d, "
+                            "GPIO pin %d)", chip, channel, self._pin)
+                return backend
+            except OSError as e:
+                logger.warning("Hardware PWM unavailable (%s) - falling back to RPi.GPIO", e)
+
+        if not _GPIO_AVAILABLE:
+            logger.warning("RPi.GPIO not available - using simulated light output")
+            return _SimGPIOBackend(self._pin)
+        backend = _RPiGPIOBackend(self._pin)
+        logger.info("Lights initialized on GPIO pin %d (software PWM)", self._pin)
+        return backend
 
     def set_enabled(self, enabled: bool):
         with self._lock:
@@ -64,7 +256,7 @@ class LightsManager:
             self._apply()
 
     def set_mode(self, mode: str):
-        """Mode: 'on', 'off', 'blink'"""
+        """Mode: 'on', 'off', 'blink', 'strobe'"""
         with self._lock:
             self._mode = mode
             self._cfg.set("lights", "mode", mode)
@@ -75,25 +267,143 @@ class LightsManager:
             "enabled": self._enabled,
             "brightness": self._brightness,
             "mode": self._mode,
-            "gpio_available": _GPIO_AVAILABLE
+            "gpio_available": _GPIO_AVAILABLE,
+            "backend": self._backend.name if self._backend else "none",
+            "strobe_pulses": self._strobe_pulses,
         }
 
+    def on_frame_start(self, timestamp: float, period: float):
+        """Camera frame-start notification: (monotonic timestamp, frame period s).
+        Only used in strobe mode to time the next exposure pulse."""
+        if not self._strobe_running:
+            return
+        with self._strobe_cond:
+            self._strobe_frame_ts = timestamp
+            self._strobe_period = period
+            self._strobe_seq += 1
+            self._strobe_cond.notify()
+
     def cleanup(self):
-        if self._pwm:
+        self._stop_strobe()
+        if self._backend:
             try:
-                self._pwm.stop()
-                GPIO.cleanup(self._pin)
+                self._backend.cleanup()
             except Exception:
                 pass
 
     def _apply(self):
-        if not _GPIO_AVAILABLE or self._pwm is None:
+        if self._backend is None:
+            return
+        strobe = self._enabled and self._mode == "strobe"
+        if strobe:
+            self._start_strobe()
             return
+        self._stop_strobe()
         if not self._enabled or self._mode == "off":
             duty = 0
         else:
             duty = self._brightness
         try:
-            self._pwm.ChangeDutyCycle(duty)
+            self._backend.set_duty(duty)
         except Exception as e:
             logger.warning("Light apply error: %s", e)
+
+    # ------------------------------------------------------------------
+    # Strobe
+    # ------------------------------------------------------------------
+
+    def _start_strobe(self):
+        if self._strobe_running:
+            return
+        try:
+            self._backend.set_level(False)
+        except Exception as e:
+            logger.warning("Light apply error: %s", e)
+            return
+        self._strobe_running = True
+        self._strobe_thread = threading.Thread(
+            target=self._strobe_loop, daemon=True, name="lights-strobe"
+        )
+        self._strobe_thread.start()
+        logger.info("Light strobe enabled")
+
+    def _stop_strobe(self):
+        if not self._strobe_running:
+            return
+        self._strobe_running = False
+        with self._strobe_cond:
+            self._strobe_cond.notify()
+        if self._strobe_thread and self._strobe_thread is not threading.current_thread():
+            self._strobe_thread.join(timeout=1)
+        self._strobe_thread = None
+
+    def _strobe_window(self, frame_ts: float, period: float) -> Optional[Tuple[float, float]]:
+        """Return (on_time, off_time) for the exposure of the frame following
+        frame_ts, or None if the exposure is unknown (auto exposure)."""
+        cam = self._cfg.get("camera") or {}
+        if cam.get("auto_exposure", False):
+            return None
+        lights = self._cfg.get("lights") or {}
+        lead = float(lights.get("strobe_lead_us", 0.0)) * 1e-6
+        margin = float(lights.get("strobe_margin_us", 500.0)) * 1e-6
+        exposure = float(cam.get("exposure", 100)) * _V4L2_EXPOSURE_UNIT_S
+        exposure = min(exposure, period)
+
+        # A frame is delivered right after its exposure ends, so the next
+        # exposure window ends one period after this frame was delivered.
+        # 'lead' compensates for the fixed transfer latency of the sensor.
+        exp_end = frame_ts + period - lead
+        pulse = exposure * max(0, min(100, self._brightness)) / 100.0
+        on_time = exp_end - exposure - margin
+        off_time = on_time + pulse + 2 * margin
+        return on_time, off_time
+
+    def _strobe_loop(self):
+        seq_seen = 0
+        lit = False
+        while self._strobe_running:
+            with self._strobe_cond:
+                while self._strobe_running and self._strobe_seq == seq_seen:
+                    self._strobe_cond.wait(timeout=0.5)
+                    if self._strobe_seq == seq_seen and lit:
+                        # Camera stalled: never leave the LEDs latched on
+                        self._set_level(False)
+                        lit = False
+                if not self._strobe_running:
+                    break
+                seq_seen = self._strobe_seq
+                frame_ts = self._strobe_frame_ts
+                period = self._strobe_period
+
+            if period <= 0:
+                continue
+            window = self._strobe_window(frame_ts, period)
+            if window is None:
+                # Exposure time unknown: stay lit for the whole frame
+                if not lit:
+                    self._set_level(True)
+                    lit = True
+                continue
+            on_time, off_time = window
+            now = time.monotonic()
+            if off_time <= now:
+                continue  # notification arrived too late for this exposure
+            if on_time > now:
+                time.sleep(on_time - now)
+            self._set_level(True)
+            lit = True
+            delay = off_time - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+            self._set_level(False)
+            lit = False
+            self._strobe_pulses += 1
+
+        if lit:
+            self._set_level(False)
+
+    def _set_level(self, on: bool):
+        try:
+            self._backend.set_level(on)
+        except Exception as e:
+            logger.warning("Light strobe error: %s", e)
@@ -10,23 +10,30 @@ import time
 import signal
 import logging
 import threading
+from concurrent.futures import ThreadPoolExecutor
 
 # Add vision_core/src to path
 sys.path.insert(0, os.path.dirname(__file__))
 
 from config_manager import ConfigManager
 from camera_manager import CameraManager
-from apriltag_detector import AprilTagDetector
+from apriltag_detector import AprilTagDetector, DetectionBatch
 from pose_calculator import PoseCalculator
 from nt_publisher import NTPublisher
 from fmap_loader import load_fmap
 from calibration import CalibrationManager
 from lights_manager import LightsManager
 from thermal_manager import ThermalManager
+from motion_gate import MotionGate
+from tag_predictor import TagPredictor
+from corner_tracker import CornerTracker
+from quality_controller import QualityController
+from frame_deadline import FrameAbandoned, FrameDeadline, NO_DEADLINE
+from async_logging import setup_async_logging, shutdown_async_logging
 
 # ── Shared state (accessed by web dashboard) ──────────────────────────────────
 _state = {
-    "detections": [],
+    "detections": DetectionBatch(),
     "robot_pose": None,
     "offset_result": None,
     "fps": 0.0,
@@ -35,9 +42,17 @@ _state = {
     "calibration_preview": None,  # latest JPEG bytes for calibration preview
     "temperature_c": 0.0,
     "thermal_state": "unknown",
+    "thermal": {},
     "throttle_fps": 0.0,
+    "low_power": False,
+    "tracking": {},  # corner tracking stats (camera 0)
+    "quality": {},  # latency-SLO operating point (camera 0)
+    "abandoned_frames": {},  # stage -> frames abandoned past their deadline
+    "startup": {},  # startup milestones (ms since process start)
+    "camera_health": [],  # per camera: connected, disconnects, last_recovery_ms
 }
 _state_lock = threading.Lock()
+_state_seq = 0  # bumped on every update so readers can skip unchanged state
 
 
 def get_shared_state() -> dict:
@@ -45,50 +60,162 @@ def get_shared_state() -> dict:
         return dict(_state)
 
 
+def get_shared_state_seq() -> int:
+    with _state_lock:
+        return _state_seq
+
+
 def update_shared_state(**kwargs):
+    global _state_seq
     with _state_lock:
         _state.update(kwargs)
+        _state_seq += 1
 
 
 # ─────────────────────────────────────────────────────────────────────────────
 
-def setup_logging(level_str: str):
+def _process_start_monotonic() -> float:
+    """Process start time on the monotonic clock, so the startup trace also
+    covers interpreter start-up and imports. Falls back to 'now'."""
+    now = time.monotonic()
+    try:
+        with open("/proc/self/stat") as f:
+            # starttime (field 22) counts clock ticks since boot; fields after
+            # the parenthesised command name are space separated
+            fields = f.read().rsplit(")", 1)[1].split()
+        start_s = int(fields[19]) / os.sysconf("SC_CLK_TCK")
+        age = time.clock_gettime(time.CLOCK_BOOTTIME) - start_s
+        if 0.0 <= age < 3600.0:
+            return now - age
+    except (OSError, ValueError, IndexError, AttributeError):
+        pass
+    return now
+
+
+_PROCESS_T0 = _process_start_monotonic()
+
+
+class StartupTrace:
+    """Startup milestones in ms since process start (first occurrence only)."""
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._marks: dict = {}
+
+    def mark(self, name: str) -> bool:
+        """Record a milestone. Returns True only the first time."""
+        if name in self._marks:
+            return False
+        with self._lock:
+            if name in self._marks:
+                return False
+            self._marks[name] = (time.monotonic() - _PROCESS_T0) * 1000.0
+            return True
+
+    def as_dict(self) -> dict:
+        with self._lock:
+            return {k: round(v, 1) for k, v in self._marks.items()}
+
+
+# ─────────────────────────────────────────────────────────────────────────────
+
+def setup_logging(level_str: str, log_cfg: dict = None):
+    """Queue-based logging: the frame path never waits on stdout or the SD card."""
     level = getattr(logging, level_str.upper(), logging.INFO)
-    logging.basicConfig(
-        level=level,
-        format="%(asctime)s [%(levelname)s] %(name)s: %(message)s",
-        handlers=[
-            logging.StreamHandler(sys.stdout),
-            logging.FileHandler("/var/log/xnav.log", mode="a")
-        ] if os.path.exists("/var/log") else [logging.StreamHandler(sys.stdout)]
+    log_cfg = log_cfg or {}
+    setup_async_logging(
+        level,
+        log_file=log_cfg.get("file", "/var/log/xnav.log"),
+        max_bytes=int(log_cfg.get("max_bytes", 5 * 1024 * 1024)),
+        backup_count=int(log_cfg.get("backup_count", 3)),
+        queue_size=int(log_cfg.get("queue_size", 10000)),
+        rate_interval=float(log_cfg.get("rate_limit_interval_s", 10.0)),
+        rate_burst=int(log_cfg.get("rate_limit_burst", 2)),
     )
 
 
 class VisionPipeline:
     def __init__(self, config_path: str = None):
+        self._startup = StartupTrace()
         kwargs = {"config_path": config_path} if config_path else {}
         self._cfg = ConfigManager(**kwargs)
-        self._camera = CameraManager(self._cfg)
-        self._detector = AprilTagDetector(self._cfg)
-        self._pose_calc = PoseCalculator(self._cfg)
-        self._nt = NTPublisher(self._cfg)
-        self._calibration = CalibrationManager(self._cfg)
-        self._lights = LightsManager(self._cfg)
-        self._thermal = ThermalManager(self._cfg)
+        self._startup.mark("config_loaded")
+
+        # One capture thread + detector per configured camera; index 0 is primary.
+        # Slow subsystems (detector init + warm-up, calibration load, GPIO) are
+        # brought up in parallel; the cheap ones are built meanwhile.
+        n_cams = self._cfg.num_cameras()
+        with ThreadPoolExecutor(max_workers=n_cams + 1, thread_name_prefix="init") as pool:
+            det_futures = [pool.submit(self._build_detector, i) for i in range(n_cams)]
+            lights_future = pool.submit(LightsManager, self._cfg)
+            self._cameras = [CameraManager(self._cfg, camera_id=i) for i in range(n_cams)]
+            self._motion_gates = [MotionGate(self._cfg, camera_id=i) for i in range(n_cams)]
+            self._predictors = [TagPredictor(self._cfg, camera_id=i) for i in range(n_cams)]
+            self._trackers = [CornerTracker(self._cfg, camera_id=i) for i in range(n_cams)]
+            self._quality = [QualityController(self._cfg, camera_id=i) for i in range(n_cams)]
+            self._pose_calc = PoseCalculator(self._cfg)
+            self._nt = NTPublisher(self._cfg)
+            self._calibration = CalibrationManager(self._cfg)
+            self._thermal = ThermalManager(self._cfg)
+            self._detectors = [f.result() for f in det_futures]
+            self._lights = lights_future.result()
+        self._camera = self._cameras[0]
+        self._detector = self._detectors[0]
         self._field_map = None
         self._running = False
+        self._startup.mark("subsystems_ready")
 
-        # Throttle state
+        # Throttle state (per camera)
         self._throttle_lock = threading.Lock()
-        self._last_process_time: float = 0.0
+        self._last_process_time = [0.0] * n_cams
+
+        # Frame deadlines: consecutive abandoned frames per camera, and
+        # abandoned frames per stage (all cameras)
+        self._abandon_streak = [0] * n_cams
+        self._abandon_lock = threading.Lock()
+        self._abandoned: dict = {}
+
+        # Open time slice: camera id -> (timestamp, detections, mount) of the
+        # results not yet published, and each camera's last result time
+        self._merge_lock = threading.Lock()
+        self._slice: dict = {}
+        self._slice_t0 = 0.0
+        self._last_result_ts = [0.0] * n_cams
+
+        # Requested camera mode preset ("" = configured) and last published mode
+        self._camera_mode = ""
+        self._published_mode = None
+
+        # Disconnect count per camera at the last health publish
+        self._published_disconnects = [0] * n_cams
+        self._published_thermal_seq = -1
+        self._published_quality = False  # sentinel: never published
+
+        # Last valid robot pose and its frame timestamp, for tag prediction
+        self._last_pose = (0.0, None)
+
+        # Last status string sent to NT ("running" / "idle")
+        self._nt_status: str = ""
 
         # Register config change handler
         self._cfg.register_callback(self._on_config_change)
 
+        # Frame-start timing drives exposure-synchronized light strobing
+        self._camera.register_frame_start_callback(self._lights.on_frame_start)
+
+        # Camera frame callbacks (each runs on its camera's capture thread).
+        # Registered up front so no frame is lost between start() and here.
+        for cam in self._cameras:
+            cam.register_frame_callback(
+                lambda frame, cid=cam.camera_id: self._on_frame(frame, cid)
+            )
+
         # Expose components for web dashboard
         self.config = self._cfg
         self.camera = self._camera
         self.detector = self._detector
+        self.cameras = self._cameras
+        self.detectors = self._detectors
         self.pose_calc = self._pose_calc
         self.nt = self._nt
         self.calibration = self._calibration
@@ -98,24 +225,23 @@ class VisionPipeline:
     def start(self):
         self._running = True
 
-        # Load field map
-        self._reload_fmap()
-
-        # Start subsystems
+        # Cameras first: each opens on its own capture thread, overlapping
+        # the (slower) V4L2 open with NT client start-up and field map load.
+        for cam in self._cameras:
+            cam.start()
         self._nt.start()
-        self._camera.start()
+        self._reload_fmap()
         self._thermal.start()
 
         update_shared_state(status="running")
-        self._nt.publish_status("running")
+        self._set_nt_status("running")
+        self._startup.mark("pipeline_started")
         logging.getLogger(__name__).info("XNav vision pipeline started")
 
-        # Camera frame callback
-        self._camera.register_frame_callback(self._on_frame)
-
     def stop(self):
         self._running = False
-        self._camera.stop()
+        for cam in self._cameras:
+            cam.stop()
         self._nt.stop()
         self._thermal.stop()
         self._lights.cleanup()
@@ -131,9 +257,23 @@ class VisionPipeline:
     # Frame processing
     # ------------------------------------------------------------------
 
-    def _on_frame(self, frame, gray, timestamp):
+    def _on_frame(self, frame, camera_id: int = 0):
         if not self._running:
             return
+        deadline = self._frame_deadline(frame, camera_id)
+        t0 = time.monotonic()
+        try:
+            self._process_frame(frame, camera_id, deadline)
+        except FrameAbandoned as e:
+            self._frame_abandoned(camera_id, e.stage, (time.monotonic() - t0) * 1000.0)
+            return
+        self._abandon_streak[camera_id] = 0
+
+    def _process_frame(self, frame, camera_id: int, deadline: FrameDeadline):
+        # Pooled frame with a lazily built gray pyramid shared by every consumer
+        gray = frame.gray
+        timestamp = frame.timestamp
+        self._startup.mark("first_frame")
 
         # ── Throttle gate ──────────────────────────────────────────────
         effective_fps = self._get_effective_throttle_fps()
@@ -141,34 +281,112 @@ class VisionPipeline:
             min_interval = 1.0 / effective_fps
             now = time.monotonic()
             with self._throttle_lock:
-                if (now - self._last_process_time) < min_interval:
+                if (now - self._last_process_time[camera_id]) < min_interval:
                     return
-                self._last_process_time = now
+                self._last_process_time[camera_id] = now
 
         t0 = time.monotonic()
 
         # Read NT inputs (turret angle, match mode)
         inputs = self._nt.read_inputs()
 
+        # Camera mode switch requested by the robot (e.g. low-res/high-fps for
+        # close-range alignment); applied in place by each capture thread
+        if camera_id == 0:
+            self._update_camera_mode(inputs.get("camera_mode", ""))
+        self._check_camera_health(camera_id)
+
         # Check match mode
         match_mode = self._cfg.get("match_mode") or inputs.get("match_mode", False)
 
-        # Detect AprilTags
-        detections = self._detector.detect(gray, timestamp)
+        # Low-power gate: while the robot is disabled, skip detection on a static scene
+        robot_active = bool(match_mode or inputs.get("robot_enabled", False))
+        process = self._motion_gates[camera_id].should_process(frame, timestamp, robot_active)
+        if camera_id == 0:
+            low_power = self._motion_gates[0].get_status()["gating"]
+            self._set_nt_status("idle" if low_power else "running")
+            if not process:
+                update_shared_state(low_power=True, status="idle")
+        if not process:
+            return
+
+        # Turret compensation only for cameras mounted on the turret
+        # (camera_mount.on_turret; the primary camera by default)
+        mount = self._cfg.camera_section(camera_id, "camera_mount")
+        turret_angle = 0.0
+        if mount.get("on_turret", camera_id == 0):
+            turret_cfg = self._cfg.get("turret") or {}
+            use_nt_turret = turret_cfg.get("enabled", False) and inputs.get("turret_enabled", False)
+            turret_angle = inputs.get("turret_angle", 0.0) if use_nt_turret else 0.0
+            turret_angle += float(turret_cfg.get("mount_angle_offset", 0.0))
+
+        # Detector operating point for the latency target
+        self._apply_operating_point(camera_id)
+
+        # Between full detections, follow the last corners with optical flow
+        # and re-solve their poses
+        t_detect = time.monotonic()
+        detector = self._detectors[camera_id]
+        tracker = self._trackers[camera_id]
+        detections = None
+        if tracker.enabled() and not tracker.detection_due(frame):
+            tracked = tracker.track(frame)
+            if tracked is not None:
+                detections = detector.solve(tracked, gray.shape[1], gray.shape[0])
+
+        if detections is None:
+            # Predict visible tags from the last pose (search ROIs + pose validity).
+            # The mount transform does not include the turret, so skip it there.
+            predictor = self._predictors[camera_id]
+            rois = None
+            predicted = False
+            if predictor.enabled():
+                pose_ts, last_pose = self._last_pose
+                if abs(turret_angle) > 0.001:
+                    last_pose = None
+                h, w = gray.shape[:2]
+                predicted = bool(predictor.update(last_pose, timestamp - pose_ts, mount,
+                                                  detector.camera_matrix(w, h), w, h))
+                if predicted:
+                    rois = predictor.search_rois()
+
+            # Detect AprilTags
+            detections = detector.detect(gray, timestamp, rois=rois, deadline=deadline)
+            if predicted:
+                predictor.report(set(detections.ids.tolist()))
+            if tracker.enabled():
+                tracker.detected(frame, detections)
+        detect_ms = (time.monotonic() - t_detect) * 1000.0
 
         # Apply turret compensation
-        turret_cfg = self._cfg.get("turret") or {}
-        use_nt_turret = turret_cfg.get("enabled", False) and inputs.get("turret_enabled", False)
-        turret_angle = inputs.get("turret_angle", 0.0) if use_nt_turret else 0.0
-        turret_angle += float(turret_cfg.get("mount_angle_offset", 0.0))
-
         if abs(turret_angle) > 0.001:
             detections = self._pose_calc.apply_turret(detections, turret_angle)
 
+        # Resolve ambiguous single-tag poses against the robot's odometry heading
+        robot_yaw = inputs.get("robot_yaw")
+        if robot_yaw is not None and self._field_map:
+            for tag_id in self._pose_calc.resolve_ambiguity(detections, robot_yaw, mount):
+                self._detectors[camera_id].flip_track(tag_id)
+
+        # Merge with the other cameras' results from the same time slice; only
+        # the camera that completes the slice publishes it
+        groups = self._merge_time_slice(camera_id, timestamp, detections, mount)
+        if groups is not None and len(groups) > 1:
+            detections = DetectionBatch.concat([dets for dets, _ in groups]).closest_per_id()
+
         # Robot pose (field-centric)
         robot_pose = None
-        if self._field_map:
-            robot_pose = self._pose_calc.compute_robot_pose(detections)
+        if self._field_map and groups is not None:
+            plausible = None
+            if (self._cfg.get("tag_prediction") or {}).get("reject_implausible", True):
+                plausible = {}
+                for cid, p in enumerate(self._predictors):
+                    ids = p.plausible_ids()
+                    if ids is not None:
+                        plausible[cid] = ids
+            robot_pose = self._pose_calc.compute_robot_pose_multi(groups, plausible)
+            if robot_pose is not None and robot_pose.valid:
+                self._last_pose = (timestamp, robot_pose)
 
         # Offset point
         offset_cfg = self._cfg.get("offset_point") or {}
@@ -176,15 +394,24 @@ class VisionPipeline:
 
         # Latency
         latency_ms = (time.monotonic() - t0) * 1000.0
-        fps = self._camera.get_fps()
+        fps = self._cameras[camera_id].get_fps()
+        self._quality[camera_id].record(latency_ms, detect_ms)
 
         # Calibration frame collection
         cal_status = self._calibration.get_status()
-        if cal_status["collecting"]:
-            self._calibration.add_frame(gray)
+        if cal_status["collecting"] and camera_id == 0:
+            self._calibration.add_frame(frame, deadline)
 
         # Update shared state for web dashboard
         thermal_status = self._thermal.get_status()
+        if camera_id == 0 and self._thermal.seq != self._published_thermal_seq:
+            self._published_thermal_seq = self._thermal.seq
+            self._nt.publish_thermal(thermal_status)
+        quality_status = self._quality[0].get_status()
+        if camera_id == 0:
+            self._publish_quality(quality_status)
+        if groups is None:
+            return
         update_shared_state(
             detections=detections,
             robot_pose=robot_pose,
@@ -194,11 +421,17 @@ class VisionPipeline:
             status="running",
             temperature_c=thermal_status["temperature_c"],
             thermal_state=thermal_status["state"],
+            thermal=thermal_status,
             throttle_fps=effective_fps,
+            low_power=self._motion_gates[0].get_status()["gating"],
+            tracking=self._trackers[0].get_status(),
+            quality=quality_status,
         )
 
         # Publish to NT
         self._nt.publish_frame(detections, robot_pose, offset_result, fps, latency_ms)
+        if self._nt.is_connected() and self._startup.mark("first_publish"):
+            self._report_startup()
 
     # ------------------------------------------------------------------
     # Config change handler
@@ -208,13 +441,139 @@ class VisionPipeline:
         if not keys:
             return
         section = keys[0]
-        if section == "field_map":
+        if section in ("field_map", "tag_prediction"):
             self._reload_fmap()
-        elif section in ("camera", "apriltag"):
-            self._detector.reload_config()
+        elif section in ("camera", "apriltag", "calibration", "cameras"):
+            for det in self._detectors:
+                det.reload_config()
+            if section in ("camera", "cameras"):
+                # Resolution / fps edits take effect live, without a restart
+                for cam in self._cameras:
+                    cam.select_mode(self._camera_mode)
         elif section == "lights":
             pass  # LightsManager reads from cfg directly
 
+    def _build_detector(self, camera_id: int) -> AprilTagDetector:
+        det = AprilTagDetector(self._cfg, camera_id=camera_id)
+        cam = self._cfg.camera_section(camera_id, "camera")
+        det.warm_up(int(cam.get("width", 1280)), int(cam.get("height", 720)))
+        return det
+
+    def _update_camera_mode(self, name: str):
+        if name != self._camera_mode:
+            self._camera_mode = name
+            for cam in self._cameras:
+                cam.select_mode(name)
+        mode = self._camera.mode
+        if mode is not None and mode != self._published_mode:
+            self._published_mode = mode
+            self._nt.publish_camera_mode("%dx%d@%d" % mode)
+
+    def _frame_deadline(self, frame, camera_id: int) -> FrameDeadline:
+        """This frame's deadline, or none when deadlines are off or the last
+        max_consecutive frames were already abandoned."""
+        dcfg = self._cfg.get("frame_deadline") or {}
+        if not dcfg.get("enabled", False) or \
+                self._abandon_streak[camera_id] >= int(dcfg.get("max_consecutive", 2)):
+            return NO_DEADLINE
+        return FrameDeadline.for_frame(frame.timestamp, self._cameras[camera_id].frame_period,
+                                       float(dcfg.get("budget_frames", 1.5)))
+
+    def _frame_abandoned(self, camera_id: int, stage: str, elapsed_ms: float):
+        """A newer frame is waiting: drop this one without publishing. The
+        time spent still counts toward the latency target."""
+        self._abandon_streak[camera_id] += 1
+        self._quality[camera_id].record(elapsed_ms, elapsed_ms)
+        with self._abandon_lock:
+            self._abandoned[stage] = self._abandoned.get(stage, 0) + 1
+            counts = dict(self._abandoned)
+        update_shared_state(abandoned_frames=counts)
+        logging.getLogger(__name__).debug("Camera %d frame abandoned in %s after %.1f ms",
+                                          camera_id, stage, elapsed_ms)
+
+    def _apply_operating_point(self, camera_id: int):
+        """Hand the quality controller's operating point (or the configured
+        settings, when it is off) to the detector and the ROI policy."""
+        point = self._quality[camera_id].operating_point()
+        predictor = self._predictors[camera_id]
+        if point is None:
+            self._detectors[camera_id].set_operating_point()
+            predictor.set_roi_policy(0)
+            return
+        self._detectors[camera_id].set_operating_point(point.quad_decimate, point.nthreads)
+        scale = int((self._cfg.get("quality_control") or {}).get("roi_interval_scale", 3))
+        predictor.set_roi_policy(scale if point.roi_tight else 0)
+
+    def _publish_quality(self, status: dict):
+        """Publish the operating point when it changes."""
+        point = (status["enabled"], status["level"], status["levels"])
+        if point != self._published_quality:
+            self._published_quality = point
+            self._nt.publish_quality(status)
+
+    def _check_camera_health(self, camera_id: int):
+        """After a hotplug recovery, publish the outage length once."""
+        health = self._cameras[camera_id].get_health()
+        if health["disconnects"] == self._published_disconnects[camera_id]:
+            return
+        self._published_disconnects[camera_id] = health["disconnects"]
+        update_shared_state(camera_health=[c.get_health() for c in self._cameras])
+        self._nt.publish_camera_health(sum(self._published_disconnects),
+                                       health["last_recovery_ms"])
+
+    def _report_startup(self):
+        trace = self._startup.as_dict()
+        update_shared_state(startup=trace)
+        self._nt.publish_startup(trace)
+        logging.getLogger(__name__).info(
+            "Startup: first frame %.0f ms, first NT publish %.0f ms (%s)",
+            trace.get("first_frame", 0.0), trace.get("first_publish", 0.0),
+            ", ".join(f"{k}={v:.0f}" for k, v in trace.items()))
+
+    def _set_nt_status(self, status: str):
+        if status != self._nt_status:
+            self._nt_status = status
+            self._nt.publish_status(status)
+
+    def _merge_time_slice(self, camera_id: int, timestamp: float, detections, mount: dict):
+        """Add this camera's result to the open time slice. Returns the slice as
+        [(detections, mount)] when this camera completes it (every live camera
+        has contributed), or None while others are still expected. A frame
+        outside the window, a second frame from the same camera, or one closer
+        to another member's next frame than to its current one starts a new
+        slice; results of a slice that never completed are superseded."""
+        if len(self._cameras) == 1:
+            return [(detections, mount)]
+
+        window = float(self._cfg.get("camera_merge_window_ms", default=15.0)) / 1000.0
+        throttle_fps = self._get_effective_throttle_fps()
+        intervals = [max(cam.frame_period, 1.0 / throttle_fps if throttle_fps > 0 else 0.0)
+                     for cam in self._cameras]
+        with self._merge_lock:
+            if (not self._slice or camera_id in self._slice
+                    or not 0.0 <= timestamp - self._slice_t0 <= window
+                    or any(timestamp - ts > abs(timestamp - ts - intervals[cid])
+                           for cid, (ts, _, _) in self._slice.items())):
+                self._slice = {}
+                self._slice_t0 = timestamp
+            self._slice[camera_id] = (timestamp, detections, mount)
+            self._last_result_ts[camera_id] = timestamp
+
+            # Wait for cameras that are delivering (a result within their last
+            # few frame intervals) and whose next frame is due inside the
+            # window; a stalled or gated camera is not waited for
+            for cid, interval in enumerate(intervals):
+                last = self._last_result_ts[cid]
+                if cid not in self._slice and timestamp - last <= 3.0 * interval \
+                        and last + interval <= self._slice_t0 + window:
+                    return None
+            slice_ = self._slice
+            self._slice = {}
+
+        groups = [(detections, mount)]
+        groups.extend((dets, m) for cid, (_, dets, m) in sorted(slice_.items()) if cid != camera_id)
+        return groups
+
     def _get_effective_throttle_fps(self) -> float:
         """Return the effective processing throttle FPS (manual or thermal auto-throttle).
         Returns 0.0 when no throttle is active (process every frame)."""
@@ -233,11 +592,13 @@ class VisionPipeline:
         enabled = fm_cfg.get("enabled", False)
         if enabled and fmap_file:
             fm = load_fmap(fmap_file)
-            self._field_map = fm
-            self._pose_calc.set_field_map(fm)
         else:
-            self._field_map = None
-            self._pose_calc.set_field_map(None)
+            fm = None
+        self._field_map = fm
+        self._pose_calc.set_field_map(fm)
+        for predictor in self._predictors:
+            predictor.set_field_map(fm)
+        self._last_pose = (0.0, None)
 
 
 # ─────────────────────────────────────────────────────────────────────────────
@@ -262,6 +623,8 @@ def main():
     logger.info("═══════════════════════════════════════════")
 
     _pipeline = VisionPipeline(config_path=config_path)
+    # Re-apply logging with the configured level / file options
+    setup_logging(_pipeline.config.get("log_level") or "INFO", _pipeline.config.get("logging"))
 
     def _signal_handler(sig, frame):
         logger.info("Registering shutdown handler...")
@@ -292,6 +655,7 @@ def main():
         _pipeline.stop()
         if _web_proc is not None:
             _web_proc.terminate()
+        shutdown_async_logging()
         sys.exit(0)
 
     signal.signal(signal.SIGTERM, _signal_handler_with_web)
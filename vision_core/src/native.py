@@ -0,0 +1,218 @@
+"""
+XNav Native Kernels
+
+ctypes loader for libxnav_native (vision_core/native):
+  - a C ABI over the AprilTag C library that takes frames as borrowed numpy
+    buffers (no copy per frame or per ROI) and returns detections as flat
+    arrays, so a frame's detections never become per-tag Python objects
+  - a batched closed-form (IPPE) square-tag pose solver returning both
+    planar solutions and their reprojection errors
+  - SIMD (NEON / SSE2 / AVX2, picked at load time) decimation and Gaussian
+    blur kernels for the detector pre-pass
+
+The library is optional. Build it on the device with
+
+  cmake -S vision_core/native -B vision_core/native/build
+  cmake --build vision_core/native/build
+
+and it is picked up from there, from XNAV_NATIVE_LIB, or from the system
+library path. Without it, `lib` is None and callers use the Python paths.
+"""
+
+import os
+import ctypes
+import ctypes.util
+import logging
+import numpy as np
+from typing import List, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+ABI_VERSION = 3
+
+_HERE = os.path.dirname(os.path.abspath(__file__))
+_SEARCH = (
+    os.environ.get("XNAV_NATIVE_LIB", ""),
+    os.path.join(_HERE, "..", "native", "build", "libxnav_native.so"),
+    "/opt/xnav/lib/libxnav_native.so",
+)
+
+_i32p = ctypes.POINTER(ctypes.c_int32)
+_u8p = ctypes.POINTER(ctypes.c_uint8)
+_f64p = ctypes.POINTER(ctypes.c_double)
+
+
+class _TagBatch(ctypes.Structure):
+    _fields_ = [
+        ("count", ctypes.c_int32),
+        ("ids", _i32p),
+        ("hamming", _i32p),
+        ("margin", ctypes.POINTER(ctypes.c_float)),
+        ("centers", ctypes.POINTER(ctypes.c_double)),
+        ("corners", ctypes.POINTER(ctypes.c_double)),
+    ]
+
+
+def _bind(lib: ctypes.CDLL):
+    lib.xnav_native_abi.restype = ctypes.c_int
+    lib.xnav_native_has_apriltag.restype = ctypes.c_int
+    lib.xnav_tag_detector_create.restype = ctypes.c_void_p
+    lib.xnav_tag_detector_create.argtypes = [ctypes.c_char_p, ctypes.c_int, ctypes.c_float,
+                                             ctypes.c_float, ctypes.c_int, ctypes.c_float]
+    lib.xnav_tag_detector_configure.restype = None
+    lib.xnav_tag_detector_configure.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_float,
+                                                ctypes.c_float, ctypes.c_int, ctypes.c_float]
+    lib.xnav_tag_detector_detect.restype = ctypes.c_int
+    lib.xnav_tag_detector_detect.argtypes = [ctypes.c_void_p, _u8p, ctypes.c_int, ctypes.c_int,
+                                             ctypes.c_int, _i32p, ctypes.c_int]
+    lib.xnav_tag_detector_batch.restype = ctypes.POINTER(_TagBatch)
+    lib.xnav_tag_detector_batch.argtypes = [ctypes.c_void_p]
+    lib.xnav_tag_detector_destroy.restype = None
+    lib.xnav_tag_detector_destroy.argtypes = [ctypes.c_void_p]
+    lib.xnav_solve_square_poses.restype = ctypes.c_int
+    lib.xnav_solve_square_poses.argtypes = [_f64p, ctypes.c_int] + [ctypes.c_double] * 5 + \
+        [_f64p, _f64p, _f64p, _i32p]
+    lib.xnav_simd_name.restype = ctypes.c_char_p
+    lib.xnav_decimate2.restype = ctypes.c_int
+    lib.xnav_decimate2.argtypes = [_u8p, ctypes.c_int, ctypes.c_int, ctypes.c_int, _u8p, ctypes.c_int]
+    lib.xnav_gaussian_blur.restype = ctypes.c_int
+    lib.xnav_gaussian_blur.argtypes = [_u8p, ctypes.c_int, ctypes.c_int, ctypes.c_int, _u8p,
+                                       ctypes.c_int, ctypes.c_float]
+
+
+def _load() -> Optional[ctypes.CDLL]:
+    candidates = [p for p in _SEARCH if p and os.path.exists(p)]
+    found = ctypes.util.find_library("xnav_native")
+    if found:
+        candidates.append(found)
+    for path in candidates:
+        try:
+            lib = ctypes.CDLL(path)
+            _bind(lib)
+        except (OSError, AttributeError) as e:
+            logger.warning("Cannot load native library %s: %s", path, e)
+            continue
+        if lib.xnav_native_abi() != ABI_VERSION:
+            logger.warning("Native library %s has ABI %d, expected %d; rebuild vision_core/native",
+                           path, lib.xnav_native_abi(), ABI_VERSION)
+            continue
+        logger.info("Native library loaded: %s (%s kernels)", os.path.realpath(path),
+                    lib.xnav_simd_name().decode())
+        return lib
+    return None
+
+
+lib = _load()
+
+
+def has_apriltag() -> bool:
+    return lib is not None and bool(lib.xnav_native_has_apriltag())
+
+
+def _as_u8(gray: np.ndarray) -> np.ndarray:
+    """The frame itself when its rows are contiguous bytes (frame pool and
+    pyramid buffers always are), else a compact copy."""
+    if gray.dtype != np.uint8 or gray.ndim != 2 or gray.strides[1] != 1:
+        return np.ascontiguousarray(gray, dtype=np.uint8)
+    return gray
+
+
+def solve_square_poses(corners: np.ndarray, camera_matrix: np.ndarray, tag_size: float):
+    """Both IPPE poses for each of N tags from undistorted pixel corners
+    (N, 4, 2), model order (-s, s), (s, s), (s, -s), (-s, -s). Returns
+    (R (N, 2, 3, 3), t (N, 2, 3), err (N, 2) RMS px, ok (N,)), best first."""
+    c = np.ascontiguousarray(corners, dtype=np.float64).reshape(-1, 4, 2)
+    n = len(c)
+    R = np.empty((n, 2, 3, 3))
+    t = np.empty((n, 2, 3))
+    err = np.empty((n, 2))
+    nsol = np.zeros(n, dtype=np.int32)
+    K = camera_matrix
+    if lib.xnav_solve_square_poses(c.ctypes.data_as(_f64p), n, K[0, 0], K[1, 1], K[0, 2], K[1, 2],
+                                   float(tag_size), R.ctypes.data_as(_f64p), t.ctypes.data_as(_f64p),
+                                   err.ctypes.data_as(_f64p), nsol.ctypes.data_as(_i32p)) < 0:
+        raise ValueError("invalid camera matrix or tag size")
+    return R, t, err, nsol == 2
+
+
+def decimate2(src: np.ndarray, dst: Optional[np.ndarray] = None) -> np.ndarray:
+    """2x2 box decimation (rounded mean) of a gray image into dst
+    ((h // 2, w // 2) uint8, allocated when None)."""
+    img = _as_u8(src)
+    h, w = img.shape
+    if dst is None:
+        dst = np.empty((h // 2, w // 2), dtype=np.uint8)
+    lib.xnav_decimate2(img.ctypes.data_as(_u8p), w, h, img.strides[0],
+                       dst.ctypes.data_as(_u8p), dst.strides[0])
+    return dst
+
+
+def gaussian_blur(src: np.ndarray, sigma: float, dst: Optional[np.ndarray] = None) -> np.ndarray:
+    """Binomial approximation of a Gaussian blur (round(sigma^2) passes of
+    [1 4 6 4 1] / 16). dst may be src for an in-place blur."""
+    img = _as_u8(src)
+    h, w = img.shape
+    if dst is None:
+        dst = np.empty_like(img)
+    lib.xnav_gaussian_blur(img.ctypes.data_as(_u8p), w, h, img.strides[0],
+                           dst.ctypes.data_as(_u8p), dst.strides[0], float(sigma))
+    return dst
+
+
+class NativeTagDetector:
+    """One native AprilTag detector (family, thread pool and result storage
+    kept across frames). Not thread-safe: one per camera thread."""
+
+    def __init__(self, family: str, nthreads: int, quad_decimate: float,
+                 quad_sigma: float, refine_edges: bool, decode_sharpening: float):
+        if not has_apriltag():
+            raise RuntimeError("native library not built with the AprilTag C library")
+        self._handle = lib.xnav_tag_detector_create(
+            family.encode(), int(nthreads), float(quad_decimate), float(quad_sigma),
+            int(bool(refine_edges)), float(decode_sharpening))
+        if not self._handle:
+            raise ValueError(f"unsupported tag family '{family}'")
+
+    def configure(self, nthreads: int, quad_decimate: float, quad_sigma: float,
+                  refine_edges: bool, decode_sharpening: float):
+        lib.xnav_tag_detector_configure(self._handle, int(nthreads), float(quad_decimate),
+                                        float(quad_sigma), int(bool(refine_edges)),
+                                        float(decode_sharpening))
+
+    def detect(self, gray: np.ndarray,
+               rois: Optional[List[Tuple[int, int, int, int]]] = None):
+        """Detect in a gray frame (or only inside the (x0, y0, x1, y1) windows,
+        best margin per id). Returns (ids, hamming, margin, centers (N, 2),
+        corners (N, 4, 2)) as views of the detector's storage, valid until
+        the next call."""
+        img = _as_u8(gray)
+        roi_arr = None
+        if rois:
+            roi_arr = np.ascontiguousarray(rois, dtype=np.int32).reshape(-1, 4)
+        n = lib.xnav_tag_detector_detect(
+            self._handle, img.ctypes.data_as(_u8p), img.shape[1], img.shape[0], img.strides[0],
+            roi_arr.ctypes.data_as(_i32p) if roi_arr is not None else None,
+            0 if roi_arr is None else len(roi_arr))
+        if n < 0:
+            raise RuntimeError("native detection failed")
+        if n == 0:
+            empty = np.zeros(0)
+            return (empty.astype(np.int32), empty.astype(np.int32), empty.astype(np.float32),
+                    empty.reshape(0, 2), empty.reshape(0, 4, 2))
+        b = lib.xnav_tag_detector_batch(self._handle).contents
+        return (np.ctypeslib.as_array(b.ids, shape=(n,)),
+                np.ctypeslib.as_array(b.hamming, shape=(n,)),
+                np.ctypeslib.as_array(b.margin, shape=(n,)),
+                np.ctypeslib.as_array(b.centers, shape=(n, 2)),
+                np.ctypeslib.as_array(b.corners, shape=(n, 4, 2)))
+
+    def close(self):
+        if self._handle:
+            lib.xnav_tag_detector_destroy(self._handle)
+            self._handle = None
+
+    def __del__(self):
+        try:
+            self.close()
+        except Exception:
+            pass
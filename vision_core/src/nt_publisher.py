@@ -3,13 +3,15 @@ XNav Network Tables Publisher
 Publishes vision data to a roboRIO via WPILib NT4 using struct format.
 
 NT Topics:
-  /XNav/status            string   - System status
+  /XNav/status            string   - System status (running / idle = low-power gating)
   /XNav/fps               float64  - Camera FPS
   /XNav/latencyMs         float64  - Processing latency (ms)
   /XNav/hasTarget         boolean  - At least one tag detected
   /XNav/numTargets        int64    - Number of detected tags
   /XNav/tagIds            int64[]  - Array of detected tag IDs
   /XNav/primaryTagId      int64    - ID of primary (closest) tag
+  /XNav/frame             float64[] - Packed frame: [count, then per tag: id, tx, ty,
+                                      x, y, z, distance, yaw, pitch, roll, ambiguity]
   /XNav/targets/<id>/tx   float64  - Horizontal angle (deg)
   /XNav/targets/<id>/ty   float64  - Vertical angle (deg)
   /XNav/targets/<id>/x    float64  - X in camera frame (m)
@@ -19,6 +21,7 @@ NT Topics:
   /XNav/targets/<id>/yaw  float64  - Yaw (deg)
   /XNav/targets/<id>/pitch float64 - Pitch (deg)
   /XNav/targets/<id>/roll float64  - Roll (deg)
+  /XNav/targets/<id>/ambiguity float64 - PnP ambiguity ratio (0 = unique, ~1 = ambiguous)
   /XNav/robotPose         float64[6] - [x,y,z,roll,pitch,yaw] field-centric
   /XNav/offsetPoint/valid boolean
   /XNav/offsetPoint/x     float64
@@ -27,11 +30,33 @@ NT Topics:
   /XNav/offsetPoint/directDistance float64
   /XNav/offsetPoint/tx    float64
   /XNav/offsetPoint/ty    float64
+  /XNav/cameraMode        string   - Active sensor mode, e.g. "640x480@120"
+  /XNav/camera/disconnects     int64   - Camera disconnects since start (all cameras)
+  /XNav/camera/lastRecoveryMs  float64 - Last disconnect -> first frame after reopen (ms)
+  /XNav/startup/firstFrameMs   float64 - Process start -> first camera frame (ms)
+  /XNav/startup/firstPublishMs float64 - Process start -> first NT publish (ms)
+  /XNav/thermal/state          string  - ok / warm / rising / throttled / hot / critical
+  /XNav/thermal/temperatureC   float64 - CPU temperature (C)
+  /XNav/thermal/slopeCPerMin   float64 - Temperature trend (C per minute)
+  /XNav/thermal/timeToThrottleS float64 - Predicted time until clock capping (s, -1 = not heating)
+  /XNav/thermal/cpuMHz         float64 - Current CPU clock
+  /XNav/thermal/throttled      boolean - Kernel/firmware is capping the CPU clock
+  /XNav/thermal/shedFps        float64 - Predictive frame-rate cap in effect (0 = none)
+  /XNav/quality/enabled        boolean - Latency-SLO quality controller active
+  /XNav/quality/level          int64   - Operating point (0 = best quality)
+  /XNav/quality/quadDecimate   float64 - Detector decimation in use
+  /XNav/quality/nthreads       int64   - Detector threads in use
+  /XNav/quality/roiPolicy      string  - configured / tight
+  /XNav/quality/p99Ms          float64 - p99 frame latency that set the point (ms)
+  /XNav/quality/sloMs          float64 - p99 latency target (ms)
 
   Inputs (robot -> XNav):
   /XNav/input/turretAngle  float64 - Turret angle (deg) from robot
   /XNav/input/turretEnabled boolean
   /XNav/input/matchMode    boolean
+  /XNav/input/robotYaw     float64 - Odometry heading (deg), used to resolve ambiguous poses
+  /XNav/input/robotEnabled boolean - Robot enabled; disables low-power motion gating
+  /XNav/input/cameraMode   string  - Camera mode preset name ("" = configured mode)
 """
 
 import threading
@@ -63,6 +88,9 @@ class NTPublisher:
         self._turret_angle: float = 0.0
         self._turret_enabled: bool = False
         self._match_mode_nt: bool = False
+        self._robot_yaw = None
+        self._robot_enabled: bool = False
+        self._camera_mode: str = ""
 
     # ------------------------------------------------------------------
     # Lifecycle
@@ -89,62 +117,124 @@ class NTPublisher:
         if not self._initialized:
             return
 
-        try:
-            self._pub("hasTarget", len(detections) > 0)
-            self._pub("numTargets", len(detections))
-            self._pub("fps", fps)
-            self._pub("latencyMs", latency_ms)
-            self._pub("tagIds", [d.id for d in detections])
-
-            # Primary target (closest)
-            if detections:
-                primary = min(detections, key=lambda d: d.distance)
-                self._pub("primaryTagId", primary.id)
-            else:
-                self._pub("primaryTagId", -1)
-
-            # Per-tag data
-            for tag in detections:
-                prefix = f"targets/{tag.id}"
-                self._pub(f"{prefix}/tx", tag.tx)
-                self._pub(f"{prefix}/ty", tag.ty)
-                self._pub(f"{prefix}/x", tag.x)
-                self._pub(f"{prefix}/y", tag.y)
-                self._pub(f"{prefix}/z", tag.z)
-                self._pub(f"{prefix}/distance", tag.distance)
-                self._pub(f"{prefix}/yaw", tag.yaw)
-                self._pub(f"{prefix}/pitch", tag.pitch)
-                self._pub(f"{prefix}/roll", tag.roll)
-
-            # Robot pose
-            if robot_pose and robot_pose.valid:
-                self._pub("robotPose", [
-                    robot_pose.x, robot_pose.y, robot_pose.z,
-                    robot_pose.roll, robot_pose.pitch, robot_pose.yaw
-                ])
-            else:
-                self._pub("robotPose", [0.0] * 6)
-
-            # Offset point
-            if offset_result and offset_result.valid:
-                self._pub("offsetPoint/valid", True)
-                self._pub("offsetPoint/x", offset_result.x)
-                self._pub("offsetPoint/y", offset_result.y)
-                self._pub("offsetPoint/z", offset_result.z)
-                self._pub("offsetPoint/directDistance", offset_result.direct_distance)
-                self._pub("offsetPoint/tx", offset_result.tx)
-                self._pub("offsetPoint/ty", offset_result.ty)
-            else:
-                self._pub("offsetPoint/valid", False)
-
-        except Exception as e:
-            logger.warning("NT publish error: %s", e)
+        with self._lock:
+            try:
+                n = len(detections)
+                self._pub("hasTarget", n > 0)
+                self._pub("numTargets", n)
+                self._pub("fps", fps)
+                self._pub("latencyMs", latency_ms)
+                self._pub("tagIds", detections.ids.tolist())
+
+                # Primary target (closest)
+                self._pub("primaryTagId", detections.primary_id())
+
+                # Whole frame in one atomic array: [count, id, tx, ty, x, y, z,
+                # distance, yaw, pitch, roll, ambiguity, id, ...]
+                self._pub("frame", detections.pack())
+
+                # Per-tag data
+                ids = detections.ids.tolist()
+                tx, ty = detections.tx.tolist(), detections.ty.tolist()
+                t = detections.t.tolist()
+                dist = detections.distance.tolist()
+                euler = detections.euler.tolist()
+                amb = detections.ambiguity.tolist()
+                for i, tag_id in enumerate(ids):
+                    prefix = f"targets/{tag_id}"
+                    self._pub(f"{prefix}/tx", tx[i])
+                    self._pub(f"{prefix}/ty", ty[i])
+                    self._pub(f"{prefix}/x", t[i][0])
+                    self._pub(f"{prefix}/y", t[i][1])
+                    self._pub(f"{prefix}/z", t[i][2])
+                    self._pub(f"{prefix}/distance", dist[i])
+                    self._pub(f"{prefix}/yaw", euler[i][2])
+                    self._pub(f"{prefix}/pitch", euler[i][1])
+                    self._pub(f"{prefix}/roll", euler[i][0])
+                    self._pub(f"{prefix}/ambiguity", amb[i])
+
+                # Robot pose
+                if robot_pose and robot_pose.valid:
+                    self._pub("robotPose", [
+                        robot_pose.x, robot_pose.y, robot_pose.z,
+                        robot_pose.roll, robot_pose.pitch, robot_pose.yaw
+                    ])
+                else:
+                    self._pub("robotPose", [0.0] * 6)
+
+                # Offset point
+                if offset_result and offset_result.valid:
+                    self._pub("offsetPoint/valid", True)
+                    self._pub("offsetPoint/x", offset_result.x)
+                    self._pub("offsetPoint/y", offset_result.y)
+                    self._pub("offsetPoint/z", offset_result.z)
+                    self._pub("offsetPoint/directDistance", offset_result.direct_distance)
+                    self._pub("offsetPoint/tx", offset_result.tx)
+                    self._pub("offsetPoint/ty", offset_result.ty)
+                else:
+                    self._pub("offsetPoint/valid", False)
+
+            except Exception as e:
+                logger.warning("NT publish error: %s", e)
+
+    def publish_camera_mode(self, mode: str):
+        with self._lock:
+            try:
+                self._pub("cameraMode", mode)
+            except Exception as e:
+                logger.warning("NT camera mode publish error: %s", e)
+
+    def publish_camera_health(self, disconnects: int, last_recovery_ms: float):
+        with self._lock:
+            try:
+                self._pub("camera/disconnects", int(disconnects))
+                self._pub("camera/lastRecoveryMs", float(last_recovery_ms))
+            except Exception as e:
+                logger.warning("NT camera health publish error: %s", e)
+
+    def publish_startup(self, trace: dict):
+        """Publish startup timing milestones (ms since process start)."""
+        with self._lock:
+            try:
+                self._pub("startup/firstFrameMs", float(trace.get("first_frame", 0.0)))
+                self._pub("startup/firstPublishMs", float(trace.get("first_publish", 0.0)))
+            except Exception as e:
+                logger.warning("NT startup publish error: %s", e)
+
+    def publish_thermal(self, thermal: dict):
+        """Publish the thermal state and the time-to-throttle prediction."""
+        with self._lock:
+            try:
+                self._pub("thermal/state", str(thermal.get("state", "unknown")))
+                self._pub("thermal/temperatureC", float(thermal.get("temperature_c", 0.0)))
+                self._pub("thermal/slopeCPerMin", float(thermal.get("slope_c_per_min", 0.0)))
+                self._pub("thermal/timeToThrottleS", float(thermal.get("time_to_throttle_s", -1.0)))
+                self._pub("thermal/cpuMHz", float(thermal.get("cpu_mhz", 0.0)))
+                self._pub("thermal/throttled", bool(thermal.get("throttled", False)))
+                self._pub("thermal/shedFps", float(thermal.get("shed_fps", 0.0)))
+            except Exception as e:
+                logger.warning("NT thermal publish error: %s", e)
+
+    def publish_quality(self, quality: dict):
+        """Publish the quality controller's operating point."""
+        with self._lock:
+            try:
+                self._pub("quality/enabled", bool(quality.get("enabled", False)))
+                self._pub("quality/level", int(quality.get("level", 0)))
+                self._pub("quality/quadDecimate", float(quality.get("quad_decimate", 0.0)))
+                self._pub("quality/nthreads", int(quality.get("nthreads", 0)))
+                self._pub("quality/roiPolicy", str(quality.get("roi_policy", "")))
+                self._pub("quality/p99Ms", float(quality.get("p99_ms", 0.0)))
+                self._pub("quality/sloMs", float(quality.get("slo_ms", 0.0)))
+            except Exception as e:
+                logger.warning("NT quality publish error: %s", e)
 
     def publish_status(self, status: str):
-        try:
-            self._pub("status", status)
-        except Exception as e:
-            logger.warning("NT status publish error: %s", e)
+        with self._lock:
+            try:
+                self._pub("status", status)
+            except Exception as e:
+                logger.warning("NT status publish error: %s", e)
 
     # ------------------------------------------------------------------
     # Input reading
@@ -155,7 +245,10 @@ class NTPublisher:
         result = {
             "turret_angle": self._turret_angle,
             "turret_enabled": self._turret_enabled,
-            "match_mode": self._match_mode_nt
+            "match_mode": self._match_mode_nt,
+            "robot_yaw": self._robot_yaw,
+            "robot_enabled": self._robot_enabled,
+            "camera_mode": self._camera_mode
         }
         if not self._initialized:
             return result
@@ -164,16 +257,26 @@ class NTPublisher:
             ta = self._sub_get("input/turretAngle", self._turret_angle)
             te = self._sub_get("input/turretEnabled", self._turret_enabled)
             mm = self._sub_get("input/matchMode", self._match_mode_nt)
+            ry = self._sub_get("input/robotYaw", float("nan"))
+            en = self._sub_get("input/robotEnabled", self._robot_enabled)
+            cm = self._sub_get("input/cameraMode", self._camera_mode)
             self._turret_angle = float(ta)
             self._turret_enabled = bool(te)
             self._match_mode_nt = bool(mm)
+            # NaN (the subscribe default) means the robot is not sending odometry
+            self._robot_yaw = None if ry != ry else float(ry)
+            self._robot_enabled = bool(en)
+            self._camera_mode = str(cm)
         except Exception as e:
             logger.debug("NT input read error: %s", e)
 
         return {
             "turret_angle": self._turret_angle,
             "turret_enabled": self._turret_enabled,
-            "match_mode": self._match_mode_nt
+            "match_mode": self._match_mode_nt,
+            "robot_yaw": self._robot_yaw,
+            "robot_enabled": self._robot_enabled,
+            "camera_mode": self._camera_mode
         }
 
     def is_connected(self) -> bool:
@@ -209,6 +312,9 @@ class NTPublisher:
         self._subscribers["input/turretAngle"] = table.getDoubleTopic("input/turretAngle").subscribe(0.0)
         self._subscribers["input/turretEnabled"] = table.getBooleanTopic("input/turretEnabled").subscribe(False)
         self._subscribers["input/matchMode"] = table.getBooleanTopic("input/matchMode").subscribe(False)
+        self._subscribers["input/robotEnabled"] = table.getBooleanTopic("input/robotEnabled").subscribe(False)
+        self._subscribers["input/robotYaw"] = table.getDoubleTopic("input/robotYaw").subscribe(float("nan"))
+        self._subscribers["input/cameraMode"] = table.getStringTopic("input/cameraMode").subscribe("")
 
         self._initialized = True
         logger.info("NT4 initialized")
@@ -247,6 +353,8 @@ class NTPublisher:
         return pub
 
     def _pub(self, key: str, value):
+        """Set one topic. Callers hold self._lock: publish_* methods run
+        on every camera thread and share the publisher table."""
         pub = self._get_pub(key, value)
         if pub is None:
             return
@@ -254,7 +362,7 @@ class NTPublisher:
             pub.set(value)
         except Exception:
             # Type mismatch - remove and recreate next time
-            del self._publishers[key]
+            self._publishers.pop(key, None)
 
     def _sub_get(self, key: str, default):
         sub = self._subscribers.get(key)
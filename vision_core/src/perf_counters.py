@@ -0,0 +1,169 @@
+"""
+XNav Performance Counters
+
+Optional hardware performance counters (Linux perf_event_open) for the
+benchmark tools: cycles, instructions, cache misses and branch misses of the
+calling thread, user space only (works at the default perf_event_paranoid
+level 2). On a noisy CM4 these show whether a change made the work itself
+cheaper even when wall time alone is inconclusive.
+
+Unavailable counters (no PMU access in a container or VM, another OS) are
+reported as None; the wall-time numbers are always there.
+"""
+
+import os
+import time
+import ctypes
+import struct
+import fcntl
+import logging
+import platform
+from contextlib import contextmanager
+from typing import Dict, Optional
+
+logger = logging.getLogger(__name__)
+
+EVENTS = ("cycles", "instructions", "cache_misses", "branch_misses")
+
+_PERF_TYPE_HARDWARE = 0
+_HW_CONFIG = {"cycles": 0, "instructions": 1, "cache_references": 2,
+              "cache_misses": 3, "branches": 4, "branch_misses": 5}
+_FORMAT_TOTAL_TIME_ENABLED = 1 << 0
+_FORMAT_TOTAL_TIME_RUNNING = 1 << 1
+_FORMAT_GROUP = 1 << 3
+_FLAG_DISABLED = 1 << 0
+_FLAG_EXCLUDE_KERNEL = 1 << 5
+_FLAG_EXCLUDE_HV = 1 << 6
+_IOC_ENABLE = 0x2400
+_IOC_RESET = 0x2403
+_IOC_FLAG_GROUP = 1
+_SYSCALL_NR = {"x86_64": 298, "aarch64": 241, "armv7l": 364, "armv6l": 364}
+
+
+class _PerfEventAttr(ctypes.Structure):
+    # PERF_ATTR_SIZE_VER5 layout; the kernel accepts older sizes
+    _fields_ = [
+        ("type", ctypes.c_uint32), ("size", ctypes.c_uint32),
+        ("config", ctypes.c_uint64), ("sample_period", ctypes.c_uint64),
+        ("sample_type", ctypes.c_uint64), ("read_format", ctypes.c_uint64),
+        ("flags", ctypes.c_uint64),
+        ("wakeup_events", ctypes.c_uint32), ("bp_type", ctypes.c_uint32),
+        ("config1", ctypes.c_uint64), ("config2", ctypes.c_uint64),
+        ("branch_sample_type", ctypes.c_uint64), ("sample_regs_user", ctypes.c_uint64),
+        ("sample_stack_user", ctypes.c_uint32), ("clockid", ctypes.c_int32),
+        ("sample_regs_intr", ctypes.c_uint64), ("aux_watermark", ctypes.c_uint32),
+        ("sample_max_stack", ctypes.c_uint16), ("reserved", ctypes.c_uint16),
+    ]
+
+
+try:
+    _libc = ctypes.CDLL(None, use_errno=True)
+    _syscall = _libc.syscall
+    _syscall.restype = ctypes.c_long
+except (OSError, AttributeError):
+    _syscall = None
+
+
+def _open_event(name: str, group_fd: int) -> int:
+    attr = _PerfEventAttr()
+    attr.type = _PERF_TYPE_HARDWARE
+    attr.size = ctypes.sizeof(_PerfEventAttr)
+    attr.config = _HW_CONFIG[name]
+    attr.read_format = _FORMAT_GROUP | _FORMAT_TOTAL_TIME_ENABLED | _FORMAT_TOTAL_TIME_RUNNING
+    attr.flags = _FLAG_EXCLUDE_KERNEL | _FLAG_EXCLUDE_HV | (_FLAG_DISABLED if group_fd < 0 else 0)
+    nr = _SYSCALL_NR.get(platform.machine())
+    # pid 0, cpu -1: this thread on any CPU
+    fd = _syscall(nr, ctypes.byref(attr), 0, -1, group_fd, 0)
+    if fd < 0:
+        raise OSError(ctypes.get_errno(), os.strerror(ctypes.get_errno()))
+    return fd
+
+
+class PerfCounters:
+    """A group of hardware counters for the thread that created it."""
+
+    def __init__(self, events=EVENTS):
+        self.events = tuple(events)
+        self._fds = []
+        if _syscall is None or platform.machine() not in _SYSCALL_NR:
+            logger.info("Performance counters unavailable on this platform")
+            return
+        try:
+            for name in self.events:
+                self._fds.append(_open_event(name, self._fds[0] if self._fds else -1))
+            fcntl.ioctl(self._fds[0], _IOC_RESET, _IOC_FLAG_GROUP)
+            fcntl.ioctl(self._fds[0], _IOC_ENABLE, _IOC_FLAG_GROUP)
+        except OSError as e:
+            logger.info("Performance counters unavailable (%s); check "
+                        "/proc/sys/kernel/perf_event_paranoid", e.strerror)
+            self.close()
+
+    @property
+    def available(self) -> bool:
+        return bool(self._fds)
+
+    def read(self) -> Optional[Dict[str, float]]:
+        """Cumulative counts, scaled up if the PMU was multiplexed."""
+        if not self._fds:
+            return None
+        n = len(self.events)
+        raw = os.read(self._fds[0], 8 * (3 + n))
+        nr, enabled, running, *values = struct.unpack("<%dQ" % (3 + n), raw)
+        scale = enabled / running if running else 0.0
+        return {name: values[i] * scale for i, name in enumerate(self.events)}
+
+    def close(self):
+        for fd in self._fds:
+            os.close(fd)
+        self._fds = []
+
+
+class StageProfiler:
+    """Accumulates wall time and counter deltas per named stage:
+
+        prof = StageProfiler()
+        with prof.stage("detect"):
+            detector.detect(gray, ts)
+        prof.report()   # per-call means
+    """
+
+    def __init__(self, use_counters: bool = True):
+        self._counters = PerfCounters() if use_counters else None
+        self._stats: Dict[str, dict] = {}
+
+    @property
+    def counters_available(self) -> bool:
+        return self._counters is not None and self._counters.available
+
+    @contextmanager
+    def stage(self, name: str):
+        c0 = self._counters.read() if self._counters else None
+        t0 = time.perf_counter()
+        try:
+            yield
+        finally:
+            wall = time.perf_counter() - t0
+            c1 = self._counters.read() if c0 is not None else None
+            st = self._stats.setdefault(name, {"calls": 0, "wall_s": 0.0, "counts": {}})
+            st["calls"] += 1
+            st["wall_s"] += wall
+            if c1 is not None:
+                for k, v in c1.items():
+                    st["counts"][k] = st["counts"].get(k, 0.0) + v - c0[k]
+
+    def report(self) -> Dict[str, dict]:
+        """Per stage: calls, mean wall ms and mean counts per call (plus IPC)."""
+        out = {}
+        for name, st in self._stats.items():
+            calls = max(1, st["calls"])
+            row = {"calls": st["calls"], "wall_ms": st["wall_s"] * 1000.0 / calls}
+            for k, v in st["counts"].items():
+                row[k] = v / calls
+            if row.get("cycles"):
+                row["ipc"] = row.get("instructions", 0.0) / row["cycles"]
+            out[name] = row
+        return out
+
+    def close(self):
+        if self._counters:
+            self._counters.close()
@@ -6,10 +6,10 @@ Computes robot-to-target, field-centric, and offset-point calculations.
 import numpy as np
 import math
 import logging
-from typing import List, Optional, Tuple, Dict
+from typing import List, Optional, Tuple, Dict, Set
 from dataclasses import dataclass, field
 
-from apriltag_detector import TagDetection
+from apriltag_detector import DetectionBatch
 from fmap_loader import FieldMap, TagPose
 
 logger = logging.getLogger(__name__)
@@ -100,6 +100,23 @@ def _quat_to_rot(qw, qx, qy, qz) -> np.ndarray:
     ])
 
 
+# Detector tag frame (seen from the front: x right, y down, z into the face)
+# in the axes of a WPILib .fmap tag pose (x out of the face, z up)
+_DETECTOR_IN_FMAP_TAG = np.array([
+    [0, 0, -1],
+    [1, 0,  0],
+    [0, -1, 0]
+], dtype=np.float64)
+
+
+def _tag_in_field(tag: TagPose) -> np.ndarray:
+    """4x4 pose of a field-map tag's detector frame in the field frame."""
+    T = np.eye(4)
+    T[:3, :3] = _quat_to_rot(tag.qw, tag.qx, tag.qy, tag.qz) @ _DETECTOR_IN_FMAP_TAG
+    T[:3, 3] = [tag.x, tag.y, tag.z]
+    return T
+
+
 def _rot_to_euler(R: np.ndarray) -> Tuple[float, float, float]:
     """3x3 rotation matrix to (roll, pitch, yaw) degrees."""
     pitch = math.degrees(math.asin(max(-1, min(1, -R[2, 0]))))
@@ -126,80 +143,46 @@ class PoseCalculator:
     # Turret compensation
     # ------------------------------------------------------------------
 
-    def apply_turret(self, detections: List[TagDetection], turret_angle_deg: float) -> List[TagDetection]:
-        """Rotate tag positions by turret angle (around Y axis)."""
-        if abs(turret_angle_deg) < 1e-6:
-            return detections
-
-        R = _rot_y(turret_angle_deg)
-        result = []
-        for tag in detections:
-            if tag.tvec is None:
-                result.append(tag)
-                continue
-            import copy
-            t = copy.copy(tag)
-            tvec_rot = R @ tag.tvec
-            t.x = float(tvec_rot[0])
-            t.y = float(tvec_rot[1])
-            t.z = float(tvec_rot[2])
-            t.distance = float(np.linalg.norm(tvec_rot))
-            t.tx = math.degrees(math.atan2(t.x, t.z))
-            t.ty = -math.degrees(math.atan2(t.y, t.z))
-            # Rotate rvec
-            if tag.rvec is not None:
-                import cv2
-                R_tag, _ = cv2.Rodrigues(tag.rvec)
-                R_new = R @ R_tag
-                rvec_new, _ = cv2.Rodrigues(R_new)
-                t.rvec = rvec_new
-                t.roll, t.pitch, t.yaw = _rvec_to_euler_simple(rvec_new)
-            result.append(t)
-        return result
+    def apply_turret(self, batch: DetectionBatch, turret_angle_deg: float) -> DetectionBatch:
+        """Rotate tag poses (both PnP solutions) by the turret angle around Y, in place."""
+        if abs(turret_angle_deg) >= 1e-6:
+            batch.rotate(_rot_y(turret_angle_deg))
+        return batch
 
     # ------------------------------------------------------------------
     # Robot pose (field-centric)
     # ------------------------------------------------------------------
 
-    def compute_robot_pose(self, detections: List[TagDetection]) -> Optional[RobotPose]:
+    def compute_robot_pose(self, batch: DetectionBatch,
+                           mount: Optional[dict] = None,
+                           plausible_ids: Optional[Set[int]] = None) -> Optional[RobotPose]:
         """Estimate robot field pose using detected tags and the field map."""
+        plausible = None
+        if plausible_ids is not None and len(batch):
+            plausible = {int(batch.camera_id[0]): plausible_ids}
+        return self.compute_robot_pose_multi([(batch, mount)], plausible)
+
+    def compute_robot_pose_multi(self, groups: List[Tuple[DetectionBatch, Optional[dict]]],
+                                 plausible: Optional[Dict[int, Set[int]]] = None) -> Optional[RobotPose]:
+        """Estimate one robot field pose from several cameras.
+        groups: [(batch, camera_mount)] - one entry per camera; a None
+        mount falls back to the top-level camera_mount config.
+        plausible: camera_id -> tag ids that can be in view from the last pose
+        (see TagPredictor); other field tags are rejected as misdetections."""
         if self._field_map is None or not self._field_map.tags:
             return None
 
-        mount = self._cfg.get("camera_mount") or {}
-        T_cam_to_robot = _build_camera_to_robot(mount)
-
         poses = []
         tag_ids = []
-
-        for tag in detections:
-            if tag.tvec is None or tag.rvec is None:
-                continue
-            field_tag = self._field_map.tags.get(tag.id)
-            if field_tag is None:
-                continue
-
-            # Camera pose in tag frame
-            import cv2
-            R_cam_tag, _ = cv2.Rodrigues(tag.rvec)
-            T_cam_in_tag = np.eye(4)
-            T_cam_in_tag[:3, :3] = R_cam_tag
-            T_cam_in_tag[:3, 3] = tag.tvec
-
-            # Tag pose in field frame
-            R_tag_field = _quat_to_rot(field_tag.qw, field_tag.qx, field_tag.qy, field_tag.qz)
-            T_tag_in_field = np.eye(4)
-            T_tag_in_field[:3, :3] = R_tag_field
-            T_tag_in_field[:3, 3] = [field_tag.x, field_tag.y, field_tag.z]
-
-            # Camera in field = tag_in_field * inv(cam_in_tag)
-            T_cam_in_field = T_tag_in_field @ np.linalg.inv(T_cam_in_tag)
-
-            # Robot in field = camera_in_field * inv(cam_to_robot)
-            T_robot_in_field = T_cam_in_field @ np.linalg.inv(T_cam_to_robot)
-
-            poses.append(T_robot_in_field)
-            tag_ids.append(tag.id)
+        for batch, mount in groups:
+            if mount is None:
+                mount = self._cfg.get("camera_mount") or {}
+            rows = self._field_rows(batch)
+            if plausible:
+                rows = self._filter_plausible(batch, rows, plausible)
+            for T_robot_in_field, tag_id in self._robot_transforms(batch, rows, mount):
+                poses.append(T_robot_in_field)
+                tag_ids.append(tag_id)
 
         if not poses:
             return None
@@ -265,11 +248,70 @@ class PoseCalculator:
             source_tag_ids=tag_ids
         )
 
+    def _field_rows(self, batch: DetectionBatch) -> np.ndarray:
+        """Row indices with a pose and a tag in the field map."""
+        known = np.fromiter((int(i) in self._field_map.tags for i in batch.ids),
+                            dtype=bool, count=len(batch))
+        return np.flatnonzero(batch.has_pose & known)
+
+    def _filter_plausible(self, batch: DetectionBatch, rows: np.ndarray,
+                          plausible: Dict[int, Set[int]]) -> np.ndarray:
+        """Drop field tags that cannot be in view of their camera. If that
+        would drop every field tag, the last pose is more likely wrong than
+        all the detections, so nothing is dropped."""
+        keep = np.ones(len(rows), dtype=bool)
+        for k, i in enumerate(rows):
+            ids = plausible.get(int(batch.camera_id[i]))
+            if ids is not None and int(batch.ids[i]) not in ids:
+                keep[k] = False
+        if keep.all() or not keep.any():
+            return rows
+        logger.debug("Rejected tag ids %s: not visible from the last robot pose",
+                     batch.ids[rows[~keep]].tolist())
+        return rows[keep]
+
+    def _robot_transforms(self, batch: DetectionBatch, rows: np.ndarray, mount: dict):
+        """Yield (T_robot_in_field, tag_id) for the given field-mapped rows."""
+        T_cam_to_robot = _build_camera_to_robot(mount)
+        for i in rows:
+            tag_id = int(batch.ids[i])
+            field_tag = self._field_map.tags[tag_id]
+            yield _robot_in_field(batch.R[i], batch.t[i], field_tag, T_cam_to_robot), tag_id
+
+    # ------------------------------------------------------------------
+    # Ambiguity resolution
+    # ------------------------------------------------------------------
+
+    def resolve_ambiguity(self, batch: DetectionBatch, robot_yaw_deg: float,
+                          mount: Optional[dict] = None) -> List[int]:
+        """For ambiguous single-tag poses, keep the PnP solution whose implied
+        robot heading agrees best with the robot's odometry heading.
+        Swaps the chosen rows in place and returns the tag ids that changed."""
+        if self._field_map is None or robot_yaw_deg is None or not len(batch):
+            return []
+        threshold = float((self._cfg.get("apriltag") or {}).get("ambiguity_threshold", 0.2))
+        if mount is None:
+            mount = self._cfg.get("camera_mount") or {}
+        T_cam_to_robot = _build_camera_to_robot(mount)
+
+        swap = []
+        for i in np.flatnonzero(batch.has_pose & batch.has_alt & (batch.ambiguity >= threshold)):
+            field_tag = self._field_map.tags.get(int(batch.ids[i]))
+            if field_tag is None:
+                continue
+            T_a = _robot_in_field(batch.R[i], batch.t[i], field_tag, T_cam_to_robot)
+            T_b = _robot_in_field(batch.R_alt[i], batch.t_alt[i], field_tag, T_cam_to_robot)
+            if _yaw_error(T_b, robot_yaw_deg) < _yaw_error(T_a, robot_yaw_deg):
+                swap.append(i)
+        if swap:
+            batch.use_alternate(swap)
+        return [int(batch.ids[i]) for i in swap]
+
     # ------------------------------------------------------------------
     # Offset point calculation
     # ------------------------------------------------------------------
 
-    def compute_offset_point(self, detections: List[TagDetection], cfg_offset: dict) -> Optional[OffsetResult]:
+    def compute_offset_point(self, batch: DetectionBatch, cfg_offset: dict) -> Optional[OffsetResult]:
         """Compute distance and angles to an offset point relative to a tag."""
         if not cfg_offset.get("enabled", False):
             return None
@@ -280,21 +322,15 @@ class PoseCalculator:
         oz = float(cfg_offset.get("z", 0.0))
 
         # Find the target tag
-        target_tag = None
-        for tag in detections:
-            if tag.id == tag_id and tag.tvec is not None and tag.rvec is not None:
-                target_tag = tag
-                break
-
-        if target_tag is None:
+        rows = np.flatnonzero((batch.ids == tag_id) & batch.has_pose)
+        if not len(rows):
             return None
+        i = rows[0]
 
         # Transform offset from tag frame to camera frame
-        import cv2
-        R_cam_tag, _ = cv2.Rodrigues(target_tag.rvec)
         offset_tag = np.array([ox, oy, oz])
         # Offset point in camera frame = tag_translation + R * offset
-        offset_cam = target_tag.tvec + R_cam_tag @ offset_tag
+        offset_cam = batch.t[i] + batch.R[i] @ offset_tag
 
         dx = float(offset_cam[0])
         dy = float(offset_cam[1])
@@ -316,10 +352,27 @@ class PoseCalculator:
         )
 
 
-def _rvec_to_euler_simple(rvec: np.ndarray) -> Tuple[float, float, float]:
-    import cv2
-    R, _ = cv2.Rodrigues(rvec)
-    roll = math.degrees(math.atan2(R[2, 1], R[2, 2]))
-    pitch = math.degrees(math.atan2(-R[2, 0], math.sqrt(R[2, 1]**2 + R[2, 2]**2)))
-    yaw = math.degrees(math.atan2(R[1, 0], R[0, 0]))
-    return roll, pitch, yaw
+def _robot_in_field(R_cam_tag: np.ndarray, tvec: np.ndarray, field_tag: TagPose,
+                    T_cam_to_robot: np.ndarray) -> np.ndarray:
+    """4x4 robot pose in the field frame from one tag observation (tag
+    rotation matrix and translation in the camera frame)."""
+    # Camera pose in tag frame
+    T_cam_in_tag = np.eye(4)
+    T_cam_in_tag[:3, :3] = R_cam_tag
+    T_cam_in_tag[:3, 3] = np.asarray(tvec).flatten()
+
+    # Tag pose in field frame (the detector's tag axes, not the .fmap's)
+    T_tag_in_field = _tag_in_field(field_tag)
+
+    # Camera in field = tag_in_field * inv(cam_in_tag)
+    T_cam_in_field = T_tag_in_field @ np.linalg.inv(T_cam_in_tag)
+
+    # Robot in field = camera_in_field * inv(cam_to_robot)
+    return T_cam_in_field @ np.linalg.inv(T_cam_to_robot)
+
+
+def _yaw_error(T_robot_in_field: np.ndarray, yaw_deg: float) -> float:
+    """Absolute wrapped heading difference (degrees)."""
+    yaw = math.degrees(math.atan2(T_robot_in_field[1, 0], T_robot_in_field[0, 0]))
+    return abs((yaw - yaw_deg + 180.0) % 360.0 - 180.0)
+
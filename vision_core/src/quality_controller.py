@@ -0,0 +1,176 @@
+"""
+XNav Quality Controller
+
+Holds frame latency to a p99 target (`quality_control.latency_slo_ms`) by
+moving along a ladder of detector operating points instead of running one
+fixed `quad_decimate` / `nthreads` / ROI setting. The per-frame cost depends
+mostly on how many tags are in view: a setting fast enough next to a wall
+of tags wastes range in open field, and the reverse misses the target.
+
+The ladder goes from best quality to cheapest:
+  1. more detector threads (lower latency, more CPU), up to max_threads
+  2. tight ROI policy: predicted search windows with a longer full-frame
+     interval (only when tag prediction is enabled)
+  3. coarser quad decimation, one `decimate_steps` entry at a time
+
+Latency over the p99 target moves one step down the ladder right away
+(after `adjust_interval_s`); p99 under `headroom` x target for
+`recover_interval_s` moves one step back up, so in open field the detector
+returns to full resolution and then gives threads back. Samples are
+cleared on every change so each operating point is judged on its own.
+"""
+
+import time
+import threading
+import logging
+import numpy as np
+from collections import deque
+from dataclasses import dataclass
+from typing import List, Optional
+
+logger = logging.getLogger(__name__)
+
+# Samples needed at an operating point before it is judged
+_MIN_SAMPLES = 20
+
+
+@dataclass(frozen=True)
+class OperatingPoint:
+    quad_decimate: float
+    nthreads: int
+    roi_tight: bool
+
+    def describe(self) -> str:
+        return "decimate %.1f, %d threads, %s ROIs" % (
+            self.quad_decimate, self.nthreads, "tight" if self.roi_tight else "configured")
+
+
+class QualityController:
+    """Per-camera p99 latency feedback over the detector operating point."""
+
+    def __init__(self, cfg, camera_id: int = 0):
+        self._cfg = cfg
+        self._camera_id = camera_id
+        self._lock = threading.Lock()
+        self._ladder: List[OperatingPoint] = []
+        self._ladder_key = None
+        self._level = 0
+        self._latency = deque()
+        self._detect = deque()
+        self._changed_at = 0.0
+        self._p99_ms = 0.0
+        self._detect_p99_ms = 0.0
+        self._changes = 0
+
+    def enabled(self) -> bool:
+        return bool(self._qcfg().get("enabled", False))
+
+    def operating_point(self) -> Optional[OperatingPoint]:
+        """The point to run this frame at, or None to use the configuration."""
+        if not self.enabled():
+            return None
+        ladder = self._build_ladder()
+        with self._lock:
+            self._level = min(self._level, len(ladder) - 1)
+            return ladder[self._level]
+
+    def record(self, latency_ms: float, detect_ms: float, now: Optional[float] = None):
+        """Add one processed frame's latency (and its detection share) and
+        step the operating point when the window calls for it."""
+        if not self.enabled():
+            return
+        qcfg = self._qcfg()
+        now = time.monotonic() if now is None else now
+        window = max(_MIN_SAMPLES, int(qcfg.get("window_frames", 120)))
+        self._latency.append(latency_ms)
+        self._detect.append(detect_ms)
+        while len(self._latency) > window:
+            self._latency.popleft()
+            self._detect.popleft()
+        if len(self._latency) < _MIN_SAMPLES:
+            return
+
+        slo = float(qcfg.get("latency_slo_ms", 25.0))
+        p99 = float(np.percentile(self._latency, 99))
+        detect_p99 = float(np.percentile(self._detect, 99))
+        held = now - self._changed_at
+        ladder = self._build_ladder()
+        step = 0
+        if p99 > slo and held >= float(qcfg.get("adjust_interval_s", 1.0)):
+            step = 1
+        elif p99 < slo * float(qcfg.get("headroom", 0.7)) \
+                and held >= float(qcfg.get("recover_interval_s", 3.0)):
+            step = -1
+
+        with self._lock:
+            self._p99_ms = p99
+            self._detect_p99_ms = detect_p99
+            level = min(max(self._level + step, 0), len(ladder) - 1)
+            if level == self._level:
+                return
+            prev = ladder[self._level]
+            self._level = level
+            self._changes += 1
+        self._changed_at = now
+        self._latency.clear()
+        self._detect.clear()
+        logger.info("Camera %d p99 latency %.1f ms (target %.1f ms): %s -> %s",
+                    self._camera_id, p99, slo, prev.describe(), ladder[level].describe())
+
+    def get_status(self) -> dict:
+        point = self.operating_point()
+        with self._lock:
+            return {
+                "enabled": point is not None,
+                "level": self._level if point is not None else 0,
+                "levels": len(self._ladder),
+                "quad_decimate": point.quad_decimate if point else 0.0,
+                "nthreads": point.nthreads if point else 0,
+                "roi_policy": ("tight" if point.roi_tight else "configured") if point else "",
+                "p99_ms": round(self._p99_ms, 2),
+                "detect_p99_ms": round(self._detect_p99_ms, 2),
+                "slo_ms": float(self._qcfg().get("latency_slo_ms", 25.0)),
+                "changes": self._changes,
+            }
+
+    # ------------------------------------------------------------------
+    # Internal
+    # ------------------------------------------------------------------
+
+    def _qcfg(self) -> dict:
+        return self._cfg.get("quality_control") or {}
+
+    def _build_ladder(self) -> List[OperatingPoint]:
+        """Operating points from best quality to cheapest (rebuilt when the
+        configuration changes; the level is kept, clamped)."""
+        qcfg = self._qcfg()
+        at_cfg = self._cfg.get("apriltag") or {}
+        pcfg = self._cfg.get("tag_prediction") or {}
+        steps = sorted(float(d) for d in qcfg.get("decimate_steps", [1.0, 1.5, 2.0, 3.0, 4.0]))
+        if not steps:
+            steps = [float(at_cfg.get("quad_decimate", 2.0))]
+        max_threads = max(1, int(qcfg.get("max_threads", at_cfg.get("nthreads", 4))))
+        min_threads = min(max(1, int(qcfg.get("min_threads", 1))), max_threads)
+        roi = bool(pcfg.get("enabled", False))
+        key = (tuple(steps), min_threads, max_threads, roi)
+        if key == self._ladder_key:
+            return self._ladder
+
+        ladder = [OperatingPoint(steps[0], n, False) for n in range(min_threads, max_threads + 1)]
+        if roi:
+            ladder.append(OperatingPoint(steps[0], max_threads, True))
+        ladder.extend(OperatingPoint(d, max_threads, roi) for d in steps[1:])
+        with self._lock:
+            if self._ladder_key is None:
+                self._level = _closest(ladder, float(at_cfg.get("quad_decimate", 2.0)),
+                                       int(at_cfg.get("nthreads", 4)))
+            self._ladder = ladder
+            self._ladder_key = key
+        return ladder
+
+
+def _closest(ladder: List[OperatingPoint], quad_decimate: float, nthreads: int) -> int:
+    """Index of the point nearest the configured settings (the start point)."""
+    costs = [(abs(p.quad_decimate - quad_decimate), abs(p.nthreads - nthreads), p.roi_tight)
+             for p in ladder]
+    return costs.index(min(costs))
@@ -0,0 +1,258 @@
+"""
+XNav Tag Predictor
+
+Predicts which field-map tags a camera should see from the last robot pose,
+the camera mount and the intrinsics. A coarse grid over the field limits the
+candidates to tags within range; each candidate is then frustum- and
+back-face-culled and projected to an image-space bounding box.
+
+The predictions are used two ways:
+- as search ROIs, so detection only looks where tags are expected (with a
+  periodic full-frame pass to discover anything the prediction missed), and
+- as a validity check for the robot pose, rejecting tag ids that cannot be
+  in view from where the robot just was.
+"""
+
+import math
+import threading
+import logging
+import numpy as np
+from dataclasses import dataclass
+from typing import Dict, List, Optional, Set, Tuple
+
+from fmap_loader import FieldMap
+from pose_calculator import RobotPose, _build_camera_to_robot, _rot_x, _rot_y, _rot_z, _tag_in_field
+
+logger = logging.getLogger(__name__)
+
+# Tags closer than this (meters, camera Z) are treated as not visible
+_NEAR_PLANE = 0.05
+
+
+@dataclass
+class PredictedTag:
+    """A field tag expected in view, with its projected bounding box (pixels)."""
+    id: int
+    x0: float
+    y0: float
+    x1: float
+    y1: float
+    distance: float
+    in_frame: bool = True    # False: only plausible given pose uncertainty
+
+
+class TagGrid:
+    """Uniform grid over the field floor (x, y) for range queries on tags."""
+
+    def __init__(self, field_map: FieldMap, cell_size: float = 2.0):
+        self.cell = max(0.1, float(cell_size))
+        self._cells: Dict[Tuple[int, int], List[int]] = {}
+        for tag in field_map.tags.values():
+            self._cells.setdefault(self._key(tag.x, tag.y), []).append(tag.id)
+
+    def _key(self, x: float, y: float) -> Tuple[int, int]:
+        return int(math.floor(x / self.cell)), int(math.floor(y / self.cell))
+
+    def query(self, x: float, y: float, radius: float) -> List[int]:
+        """Tag ids in every cell overlapping the circle (superset of the circle)."""
+        kx0, ky0 = self._key(x - radius, y - radius)
+        kx1, ky1 = self._key(x + radius, y + radius)
+        ids = []
+        for kx in range(kx0, kx1 + 1):
+            for ky in range(ky0, ky1 + 1):
+                ids.extend(self._cells.get((kx, ky), ()))
+        return ids
+
+
+class TagPredictor:
+    """Per-camera visible-tag prediction and search-ROI policy."""
+
+    def __init__(self, cfg, camera_id: int = 0):
+        self._cfg = cfg
+        self._camera_id = camera_id
+        self._lock = threading.Lock()
+        self._field_map: Optional[FieldMap] = None
+        self._grid: Optional[TagGrid] = None
+        # id -> 4x4 detector tag frame in field; corners are 4x4 homogeneous columns in tag frame
+        self._tag_T: Dict[int, np.ndarray] = {}
+        self._corners_tag: Optional[np.ndarray] = None
+        self._corners_size = 0.0
+        self._predicted: Dict[int, PredictedTag] = {}
+        self._frame_size: Tuple[int, int] = (0, 0)
+        self._frames_since_full = 0
+        self._force_full = True
+        # Full-frame interval multiplier while the ROI policy is tightened
+        # (quality controller); 0 = configured policy
+        self._tight_scale = 0
+
+    def set_field_map(self, field_map: Optional[FieldMap]):
+        tag_T = {}
+        grid = None
+        if field_map is not None and field_map.tags:
+            cell = float(self._pcfg().get("grid_cell_m", 2.0))
+            grid = TagGrid(field_map, cell)
+            for tag in field_map.tags.values():
+                tag_T[tag.id] = _tag_in_field(tag)
+        with self._lock:
+            self._field_map = field_map
+            self._grid = grid
+            self._tag_T = tag_T
+            self._corners_tag = None
+            self._predicted = {}
+            self._force_full = True
+
+    def enabled(self) -> bool:
+        return bool(self._pcfg().get("enabled", False)) and self._grid is not None
+
+    # ------------------------------------------------------------------
+    # Prediction
+    # ------------------------------------------------------------------
+
+    def update(self, robot_pose: Optional[RobotPose], pose_age_s: float, mount: dict,
+               camera_matrix: np.ndarray, width: int, height: int) -> Dict[int, PredictedTag]:
+        """Recompute the predicted tags for this frame. An empty result means
+        no usable prediction (no field map, no recent pose)."""
+        pcfg = self._pcfg()
+        max_age = float(pcfg.get("max_pose_age_s", 0.5))
+        with self._lock:
+            if (self._grid is None or robot_pose is None or not robot_pose.valid
+                    or pose_age_s > max_age):
+                self._predicted = {}
+                return {}
+            tag_size = float((self._cfg.get("apriltag") or {}).get("tag_size", 0.1524))
+            predicted = self._predict(robot_pose, mount, camera_matrix, width, height,
+                                      tag_size, pcfg)
+            self._predicted = predicted
+            self._frame_size = (width, height)
+            return predicted
+
+    def _predict(self, robot_pose: RobotPose, mount: dict, K: np.ndarray,
+                 width: int, height: int, tag_size: float, pcfg: dict) -> Dict[int, PredictedTag]:
+        T_robot = np.eye(4)
+        T_robot[:3, :3] = _rot_z(robot_pose.yaw) @ _rot_y(robot_pose.pitch) @ _rot_x(robot_pose.roll)
+        T_robot[:3, 3] = [robot_pose.x, robot_pose.y, robot_pose.z]
+        # Inverse of the chain used by PoseCalculator (robot = cam_in_field * inv(cam_to_robot))
+        T_cam_in_field = T_robot @ _build_camera_to_robot(mount)
+        T_field_to_cam = np.linalg.inv(T_cam_in_field)
+
+        max_range = float(pcfg.get("max_range_m", 8.0))
+        slack = float(pcfg.get("plausible_margin", 0.5))
+        min_cos = math.cos(math.radians(float(pcfg.get("max_view_angle_deg", 80.0))))
+
+        if self._corners_tag is None or self._corners_size != tag_size:
+            # Same corner order as the detector's PnP object points
+            s = tag_size / 2.0
+            self._corners_tag = np.array([[-s, s, 0, 1], [s, s, 0, 1],
+                                          [s, -s, 0, 1], [-s, -s, 0, 1]], dtype=np.float64).T
+            self._corners_size = tag_size
+
+        cam_pos = T_cam_in_field[:3, 3]
+        predicted = {}
+        for tag_id in self._grid.query(cam_pos[0], cam_pos[1], max_range):
+            T_tag_in_cam = T_field_to_cam @ self._tag_T[tag_id]
+            center = T_tag_in_cam[:3, 3]
+            dist = float(np.linalg.norm(center))
+            if dist > max_range or dist < 1e-6:
+                continue
+            # Tag +Z points away from the camera when its face is visible
+            cos_view = float(T_tag_in_cam[:3, 2] @ center) / dist
+            if cos_view < -0.2:
+                continue
+
+            pts = (T_tag_in_cam @ self._corners_tag)[:3]
+            if np.any(pts[2] < _NEAR_PLANE):
+                continue
+            u = K[0, 0] * pts[0] / pts[2] + K[0, 2]
+            v = K[1, 1] * pts[1] / pts[2] + K[1, 2]
+            x0, x1 = float(u.min()), float(u.max())
+            y0, y1 = float(v.min()), float(v.max())
+
+            # Plausible if within the image grown by the pose-uncertainty slack
+            sx, sy = width * slack, height * slack
+            if x1 < -sx or y1 < -sy or x0 > width + sx or y0 > height + sy:
+                continue
+            in_frame = (cos_view >= min_cos and x1 >= 0 and y1 >= 0
+                        and x0 < width and y0 < height)
+            predicted[tag_id] = PredictedTag(tag_id, x0, y0, x1, y1, dist, in_frame)
+        return predicted
+
+    def plausible_ids(self) -> Optional[Set[int]]:
+        """Ids that could be in view, or None when there is no prediction."""
+        with self._lock:
+            return set(self._predicted) or None
+
+    # ------------------------------------------------------------------
+    # Search ROIs
+    # ------------------------------------------------------------------
+
+    def set_roi_policy(self, tight_scale: int = 0):
+        """Tighten the search policy: ROIs on even without roi_search, and
+        full_frame_interval times tight_scale. 0 restores the configured one."""
+        self._tight_scale = max(0, int(tight_scale))
+
+    def search_rois(self) -> Optional[List[Tuple[int, int, int, int]]]:
+        """Merged (x0, y0, x1, y1) search windows for this frame, or None for a
+        full-frame pass (no prediction, periodic re-discovery, or the windows
+        would cover most of the image anyway)."""
+        pcfg = self._pcfg()
+        tight = self._tight_scale
+        if not pcfg.get("roi_search", False) and not tight:
+            return None
+        with self._lock:
+            boxes = [p for p in self._predicted.values() if p.in_frame]
+            width, height = self._frame_size
+            interval = int(pcfg.get("full_frame_interval", 10)) * max(1, tight)
+            if (self._force_full or not boxes or width <= 0
+                    or self._frames_since_full >= interval):
+                self._force_full = False
+                self._frames_since_full = 0
+                return None
+            self._frames_since_full += 1
+
+        margin = float(pcfg.get("roi_margin", 0.5))
+        min_size = int(pcfg.get("roi_min_px", 64))
+        rois = []
+        for p in boxes:
+            w, h = p.x1 - p.x0, p.y1 - p.y0
+            pad_x = max(w * margin, (min_size - w) / 2.0, 0.0)
+            pad_y = max(h * margin, (min_size - h) / 2.0, 0.0)
+            rois.append([max(0, int(p.x0 - pad_x)), max(0, int(p.y0 - pad_y)),
+                         min(width, int(math.ceil(p.x1 + pad_x))),
+                         min(height, int(math.ceil(p.y1 + pad_y)))])
+        rois = _merge_boxes(rois)
+
+        area = sum((r[2] - r[0]) * (r[3] - r[1]) for r in rois)
+        if area > float(pcfg.get("max_roi_fraction", 0.6)) * width * height:
+            return None
+        return [tuple(r) for r in rois]
+
+    def report(self, detected_ids: Set[int]):
+        """Feed back what was found; when none of the tags expected in frame
+        were detected the pose is likely off, so the next frame searches the
+        full image. Individually occluded tags wait for the periodic pass."""
+        with self._lock:
+            expected = {i for i, p in self._predicted.items() if p.in_frame}
+            if expected and not (expected & detected_ids):
+                self._force_full = True
+
+    def _pcfg(self) -> dict:
+        return self._cfg.get("tag_prediction") or {}
+
+
+def _merge_boxes(boxes: List[List[int]]) -> List[List[int]]:
+    """Union overlapping (x0, y0, x1, y1) boxes until none overlap."""
+    merged = True
+    while merged and len(boxes) > 1:
+        merged = False
+        out = []
+        for b in boxes:
+            for o in out:
+                if b[0] < o[2] and o[0] < b[2] and b[1] < o[3] and o[1] < b[3]:
+                    o[0], o[1] = min(o[0], b[0]), min(o[1], b[1])
+                    o[2], o[3] = max(o[2], b[2]), max(o[3], b[3])
+                    merged = True
+                    break
+            else:
+                out.append(b)
+        boxes = out
+    return boxes
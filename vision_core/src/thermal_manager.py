@@ -4,12 +4,21 @@ XNav Thermal Manager
 Monitors CPU temperature and manages processing throttle to prevent overheating.
 This is a critical system - temperature events NEVER trigger a shutdown, only
 reduced processing load.
+
+Besides the fixed thresholds, the monitor fits the temperature slope over a
+short window and predicts the time until the kernel/firmware starts capping
+the CPU clock. Load is shed ahead of that point: a planned drop in frame
+rate is far better mid-match than the latency spikes of a frequency cap.
+Frequency capping that is already happening (cpufreq below maximum, the
+Raspberry Pi firmware throttled flags) is detected and shed against as well.
 """
 
 import os
 import time
 import threading
 import logging
+from collections import deque
+from typing import Optional, Tuple
 
 logger = logging.getLogger(__name__)
 
@@ -19,6 +28,18 @@ _THERMAL_ZONE_PATHS = [
     "/sys/class/thermal/thermal_zone1/temp",
 ]
 
+_CPUFREQ_DIR = "/sys/devices/system/cpu/cpu0/cpufreq"
+_THERMAL_ZONE_DIR = "/sys/class/thermal/thermal_zone0"
+# Raspberry Pi firmware throttle flags (same bits as `vcgencmd get_throttled`;
+# the firmware driver writes them as bare hex, e.g. "a")
+_RPI_THROTTLED_PATH = "/sys/devices/platform/soc/soc:firmware/get_throttled"
+_RPI_FREQ_CAPPED = 1 << 1
+_RPI_THROTTLED = 1 << 2
+_RPI_SOFT_TEMP_LIMIT = 1 << 3
+
+# Reported time-to-throttle when the temperature is not rising
+NO_PREDICTION = -1.0
+
 
 def _read_cpu_temp() -> float:
     """Read CPU temperature in Celsius. Returns 0.0 if unavailable."""
@@ -34,13 +55,61 @@ def _read_cpu_temp() -> float:
     return 0.0
 
 
+def _read_int(path: str, base: int = 10) -> Optional[int]:
+    try:
+        with open(path) as f:
+            return int(f.read().strip(), base)
+    except (OSError, ValueError):
+        return None
+
+
+def _read_cpu_freq() -> Tuple[float, float]:
+    """(current, maximum) CPU0 clock in MHz; (0, 0) if cpufreq is unavailable."""
+    cur = _read_int(os.path.join(_CPUFREQ_DIR, "scaling_cur_freq"))
+    top = _read_int(os.path.join(_CPUFREQ_DIR, "cpuinfo_max_freq"))
+    if not cur or not top:
+        return 0.0, 0.0
+    return cur / 1000.0, top / 1000.0
+
+
+def _read_passive_trip_c() -> Optional[float]:
+    """Lowest passive (frequency-capping) trip point of the CPU zone, in C."""
+    trips = []
+    for i in range(8):
+        kind_path = os.path.join(_THERMAL_ZONE_DIR, f"trip_point_{i}_type")
+        try:
+            with open(kind_path) as f:
+                kind = f.read().strip()
+        except OSError:
+            break
+        temp = _read_int(os.path.join(_THERMAL_ZONE_DIR, f"trip_point_{i}_temp"))
+        if kind == "passive" and temp:
+            trips.append(temp / 1000.0)
+    return min(trips) if trips else None
+
+
+def _fit_slope(samples) -> float:
+    """Least-squares slope (C per second) of (time, temp) samples."""
+    n = len(samples)
+    if n < 3:
+        return 0.0
+    t0 = samples[0][0]
+    mt = sum(t - t0 for t, _ in samples) / n
+    my = sum(y for _, y in samples) / n
+    var = sum((t - t0 - mt) ** 2 for t, _ in samples)
+    if var <= 0.0:
+        return 0.0
+    return sum((t - t0 - mt) * (y - my) for t, y in samples) / var
+
+
 class ThermalManager:
     """
     Reads CPU temperature on a background thread and exposes the current
     temperature and thermal state.  Provides an auto-throttle FPS recommendation
     when the device is running hot.
 
-    States: ok / warm / hot / critical
+    States: ok / warm / rising (throttle predicted) / throttled (clock capped) /
+    hot / critical.
     The system never shuts down due to temperature - only processing load is reduced.
     """
 
@@ -49,6 +118,17 @@ class ThermalManager:
         self._lock = threading.Lock()
         self._temp_c: float = 0.0
         self._state: str = "unknown"
+        self._slope_c_per_s: float = 0.0
+        self._time_to_throttle_s: float = NO_PREDICTION
+        self._throttle_temp_c: float = 0.0
+        self._cpu_mhz: float = 0.0
+        self._cpu_max_mhz: float = 0.0
+        self._throttled: bool = False
+        self._shed_fps: float = 0.0
+        self._shed_start_c: float = 0.0
+        self._seq = 0
+        self._samples = deque()
+        self._base_limit: Optional[int] = None
         self._running = False
         self._thread: threading.Thread = None
 
@@ -83,11 +163,22 @@ class ThermalManager:
 
     def get_status(self) -> dict:
         with self._lock:
-            return {"temperature_c": round(self._temp_c, 1), "state": self._state}
+            return {"temperature_c": round(self._temp_c, 1), "state": self._state,
+                    "slope_c_per_min": round(self._slope_c_per_s * 60.0, 2),
+                    "time_to_throttle_s": round(self._time_to_throttle_s, 1),
+                    "throttle_temp_c": round(self._throttle_temp_c, 1),
+                    "cpu_mhz": round(self._cpu_mhz), "cpu_max_mhz": round(self._cpu_max_mhz),
+                    "throttled": self._throttled, "shed_fps": self._shed_fps}
+
+    @property
+    def seq(self) -> int:
+        """Incremented on every sample; lets callers publish only new data."""
+        return self._seq
 
     def get_auto_throttle_fps(self) -> float:
         """
-        Return an auto-throttle FPS cap based on current temperature.
+        Return an auto-throttle FPS cap based on current temperature, the
+        predicted time to kernel throttling and any active clock capping.
         Returns 0.0 when no thermal throttling is needed.
         """
         thermal_cfg = self._cfg.get("thermal") or {}
@@ -98,46 +189,136 @@ class ThermalManager:
 
         with self._lock:
             temp = self._temp_c
+            shed = self._shed_fps
 
         if temp >= temp_crit:
             return fps_crit
         if temp >= temp_hot:
-            return fps_hot
-        return 0.0
+            return min(fps_hot, shed) if shed > 0 else fps_hot
+        return shed
 
     # ------------------------------------------------------------------
     # Background loop
     # ------------------------------------------------------------------
 
     def _monitor_loop(self):
+        passive_trip = _read_passive_trip_c()
+        if passive_trip:
+            logger.info("Kernel passive trip point: %.1f°C", passive_trip)
         while self._running:
-            temp = _read_cpu_temp()
-
             thermal_cfg = self._cfg.get("thermal") or {}
-            warn_c = float(thermal_cfg.get("temp_warn_c", 70.0))
-            hot_c  = float(thermal_cfg.get("temp_hot_c",  75.0))
-            crit_c = float(thermal_cfg.get("temp_crit_c", 80.0))
-
-            if temp == 0.0:
-                state = "unknown"
-            elif temp >= crit_c:
-                state = "critical"
+            interval = max(0.1, float(thermal_cfg.get("sample_interval_s", 0.5)))
+            self._sample(thermal_cfg, passive_trip, time.monotonic())
+            time.sleep(interval)
+
+    def _sample(self, thermal_cfg: dict, passive_trip: Optional[float], now: float):
+        temp = _read_cpu_temp()
+        cur_mhz, max_mhz = _read_cpu_freq()
+        flags = _read_int(_RPI_THROTTLED_PATH, 16) or 0
+
+        warn_c = float(thermal_cfg.get("temp_warn_c", 70.0))
+        hot_c  = float(thermal_cfg.get("temp_hot_c",  75.0))
+        crit_c = float(thermal_cfg.get("temp_crit_c", 80.0))
+        # The clock is capped at the kernel's passive trip point (or the
+        # configured firmware soft limit), whichever comes first
+        throttle_c = float(thermal_cfg.get("throttle_temp_c", 80.0))
+        if passive_trip:
+            throttle_c = min(throttle_c, passive_trip)
+
+        # Temperature slope over the recent window
+        window = float(thermal_cfg.get("slope_window_s", 20.0))
+        if temp > 0.0:
+            self._samples.append((now, temp))
+        while self._samples and now - self._samples[0][0] > window:
+            self._samples.popleft()
+        slope = _fit_slope(self._samples)
+
+        min_slope = float(thermal_cfg.get("min_slope_c_per_min", 0.5)) / 60.0
+        if temp > 0.0 and slope > min_slope and temp < throttle_c:
+            time_to_throttle = (throttle_c - temp) / slope
+        elif temp >= throttle_c:
+            time_to_throttle = 0.0
+        else:
+            time_to_throttle = NO_PREDICTION
+
+        # Clock capping already in effect: the kernel lowered the frequency
+        # ceiling below where it started (a deliberate underclock is the
+        # baseline, not a cap), or the firmware reports it
+        limit = _read_int(os.path.join(_CPUFREQ_DIR, "scaling_max_freq"))
+        if limit and self._base_limit is None:
+            self._base_limit = limit
+        freq_capped = bool(limit and self._base_limit and limit < self._base_limit * 0.99)
+        throttled = bool(flags & (_RPI_FREQ_CAPPED | _RPI_THROTTLED | _RPI_SOFT_TEMP_LIMIT)) \
+            or freq_capped
+
+        # Shed ahead of the prediction: full horizon -> first step, a third of
+        # it (or an active cap) -> the hot rate. Hysteresis on the way out:
+        # shedding flattens the slope, so the cap is also held on temperature
+        # until it falls release_margin_c below where shedding began (or
+        # release_below_throttle_c below the throttle point); within that
+        # band a flat slope (no prediction) counts as past the horizon.
+        horizon = float(thermal_cfg.get("predict_horizon_s", 60.0))
+        fps_shed = float(thermal_cfg.get("throttle_fps_predict", 30.0))
+        fps_hot = float(thermal_cfg.get("throttle_fps_hot", 15.0))
+        prev_shed = self._shed_fps
+        release_c = max(self._shed_start_c - float(thermal_cfg.get("release_margin_c", 2.0)),
+                        throttle_c - float(thermal_cfg.get("release_below_throttle_c", 15.0)))
+        if throttled or 0.0 <= time_to_throttle < horizon / 3.0:
+            shed = fps_hot
+        elif 0.0 <= time_to_throttle < horizon:
+            shed = fps_shed
+        elif prev_shed > 0 and (0.0 <= time_to_throttle < horizon * 1.5 or temp > release_c):
+            shed = prev_shed
+        else:
+            shed = 0.0
+        if shed <= 0.0:
+            self._shed_start_c = 0.0
+        elif prev_shed <= 0.0:
+            self._shed_start_c = temp
+
+        if temp == 0.0:
+            state = "unknown"
+        elif temp >= crit_c:
+            state = "critical"
+        elif temp >= hot_c:
+            state = "hot"
+        elif throttled:
+            state = "throttled"
+        elif shed > 0:
+            state = "rising"
+        elif temp >= warn_c:
+            state = "warm"
+        else:
+            state = "ok"
+
+        with self._lock:
+            prev_state = self._state
+            self._temp_c = temp
+            self._state = state
+            self._slope_c_per_s = slope
+            self._time_to_throttle_s = time_to_throttle
+            self._throttle_temp_c = throttle_c
+            self._cpu_mhz = cur_mhz
+            self._cpu_max_mhz = max_mhz
+            self._throttled = throttled
+            self._shed_fps = shed
+            self._seq += 1
+
+        if state != prev_state:
+            if state == "critical":
                 logger.warning(
                     "CPU temperature CRITICAL: %.1f°C - throttling to minimum processing rate", temp
                 )
-            elif temp >= hot_c:
-                state = "hot"
+            elif state == "hot":
                 logger.warning(
                     "CPU temperature HOT: %.1f°C - auto-throttling processing", temp
                 )
-            elif temp >= warn_c:
-                state = "warm"
+            elif state == "throttled":
+                logger.warning("CPU clock capped (%.0f/%.0f MHz, flags 0x%x) at %.1f°C - "
+                               "shedding load to %.0f fps", cur_mhz, max_mhz, flags, temp, shed)
+            elif state == "rising":
+                logger.warning("CPU temperature %.1f°C rising %.1f°C/min, throttle at %.0f°C "
+                               "predicted in %.0f s - shedding load to %.0f fps",
+                               temp, slope * 60.0, throttle_c, time_to_throttle, shed)
+            elif state == "warm":
                 logger.info("CPU temperature warm: %.1f°C", temp)
-            else:
-                state = "ok"
-
-            with self._lock:
-                self._temp_c = temp
-                self._state = state
-
-            time.sleep(2.0)
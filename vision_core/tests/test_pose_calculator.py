@@ -0,0 +1,90 @@
+"""
+XNav pose calculator checks: field-map tag frames, the robot pose chain and
+odometry-based ambiguity resolution.
+
+Run with: python3 -m unittest discover vision_core/tests
+"""
+
+import os
+import sys
+import unittest
+import numpy as np
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src"))
+from apriltag_detector import DetectionBatch                         # noqa: E402
+from fmap_loader import FieldMap, TagPose                            # noqa: E402
+from pose_calculator import PoseCalculator, _build_camera_to_robot, _rot_y   # noqa: E402
+
+# Level camera facing the robot's front, 0.5 m up
+MOUNT = {"x_offset": 0.0, "y_offset": 0.0, "z_offset": 0.5,
+         "roll": -90.0, "pitch": 0.0, "yaw": -90.0}
+
+
+class _Config:
+    def __init__(self, sections):
+        self._sections = sections
+
+    def get(self, key):
+        return self._sections.get(key)
+
+
+def _calculator():
+    fm = FieldMap()
+    # WPILib .fmap pose: 4 m ahead at camera height, facing back down the field
+    fm.tags[1] = TagPose(1, 4.0, 0.0, 0.5, qw=0.0, qx=0.0, qy=0.0, qz=1.0)
+    calc = PoseCalculator(_Config({"camera_mount": MOUNT,
+                                   "apriltag": {"ambiguity_threshold": 0.2}}))
+    calc.set_field_map(fm)
+    return calc
+
+
+def _batch(R, t, R_alt=None, t_alt=None, ambiguity=0.0):
+    batch = DetectionBatch(1)
+    batch.ids[0] = 1
+    batch.has_pose[0] = True
+    batch.R[0], batch.t[0] = R, t
+    if R_alt is not None:
+        batch.has_alt[0] = True
+        batch.R_alt[0], batch.t_alt[0] = R_alt, t_alt
+    batch.ambiguity[0] = ambiguity
+    batch.update_derived()
+    return batch
+
+
+class HeadOnObservation(unittest.TestCase):
+    """A tag straight ahead, seen square-on: the detector reports R = I."""
+
+    def test_robot_pose(self):
+        pose = _calculator().compute_robot_pose(_batch(np.eye(3), [0.0, 0.0, 4.0]), MOUNT)
+        self.assertTrue(pose.valid)
+        np.testing.assert_allclose([pose.x, pose.y, pose.z], [0.0, 0.0, 0.0], atol=1e-9)
+        np.testing.assert_allclose([pose.roll, pose.pitch, pose.yaw], [0.0, 0.0, 0.0], atol=1e-6)
+
+    def test_turned_robot(self):
+        # Robot 1 m left of the tag's axis, turned 20 deg left: the tag is
+        # seen rotated about the camera's vertical (y) axis
+        calc = _calculator()
+        T_robot = np.eye(4)
+        c, s = np.cos(np.radians(20.0)), np.sin(np.radians(20.0))
+        T_robot[:3, :3] = [[c, -s, 0], [s, c, 0], [0, 0, 1]]
+        T_robot[:3, 3] = [0.0, 1.0, 0.0]
+        T_cam = T_robot @ _build_camera_to_robot(MOUNT)
+        tag_cam = np.linalg.inv(T_cam) @ np.array([4.0, 0.0, 0.5, 1.0])
+        pose = calc.compute_robot_pose(_batch(_rot_y(20.0), tag_cam[:3]), MOUNT)
+        np.testing.assert_allclose([pose.x, pose.y, pose.yaw], [0.0, 1.0, 20.0], atol=1e-6)
+
+    def test_ambiguity_keeps_true_heading(self):
+        # The detector's first choice is the mirrored planar solution; the
+        # alternate (R = I) implies the true heading of 0 deg
+        calc = _calculator()
+        t = np.array([0.0, 0.0, 4.0])
+        batch = _batch(_rot_y(50.0), t, np.eye(3), t, ambiguity=0.6)
+        self.assertEqual(calc.resolve_ambiguity(batch, 0.0, MOUNT), [1])
+        np.testing.assert_allclose(batch.R[0], np.eye(3), atol=1e-12)
+
+        batch = _batch(np.eye(3), t, _rot_y(50.0), t, ambiguity=0.6)
+        self.assertEqual(calc.resolve_ambiguity(batch, 0.0, MOUNT), [])
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+"""
+XNav Latency Rig
+
+Measures true end-to-end latency: frame injection -> detection -> NT ->
+XNav getter on the client. Synthetic frames each carry one AprilTag whose
+id is the frame counter (cycling through a range of ids), and are fed to a
+running XNav through a fake camera:
+
+  shm   file-backed fake camera (camera.device = "shm:/dev/shm/xnav_rig");
+        runs on any Linux box, no kernel module
+  v4l2  a v4l2loopback output device (camera.device = the loopback node),
+        which also exercises the V4L2 capture path
+
+The client side is roborio_library/tools/latency_probe.cpp: it polls the
+XNavLib getters and prints each newly seen tag id with its CLOCK_MONOTONIC
+time, which is the clock time.monotonic() uses here, so both ends run on the
+same box and timestamps compare directly.
+
+Example (XNav running locally with camera.device = "shm:/dev/shm/xnav_rig"):
+  python3 latency_rig.py --probe "./xnav_latency_probe 127.0.0.1" --frames 600
+"""
+
+import os
+import sys
+import json
+import time
+import shlex
+import fcntl
+import ctypes
+import argparse
+import threading
+import subprocess
+import cv2
+import numpy as np
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src"))
+from fake_camera import FakeFrameWriter  # noqa: E402
+
+
+# ─── v4l2loopback output ──────────────────────────────────────────────────────
+
+class _PixFormat(ctypes.Structure):
+    _fields_ = [(name, ctypes.c_uint32) for name in (
+        "width", "height", "pixelformat", "field", "bytesperline", "sizeimage",
+        "colorspace", "priv", "flags", "ycbcr_enc", "quantization", "xfer_func")]
+
+
+class _FormatUnion(ctypes.Union):
+    _fields_ = [("pix", _PixFormat), ("raw", ctypes.c_uint8 * 200), ("_align", ctypes.c_void_p)]
+
+
+class _Format(ctypes.Structure):
+    _fields_ = [("type", ctypes.c_uint32), ("fmt", _FormatUnion)]
+
+
+_V4L2_BUF_TYPE_VIDEO_OUTPUT = 2
+_V4L2_FIELD_NONE = 1
+_V4L2_PIX_FMT_YUYV = ord("Y") | ord("U") << 8 | ord("Y") << 16 | ord("V") << 24
+# _IOWR('V', 5, struct v4l2_format)
+_VIDIOC_S_FMT = (3 << 30) | (ctypes.sizeof(_Format) << 16) | (ord("V") << 8) | 5
+
+
+class LoopbackWriter:
+    """Writes gray frames as YUYV to a v4l2loopback device."""
+
+    def __init__(self, device: str, width: int, height: int):
+        self._fd = os.open(device, os.O_RDWR)
+        fmt = _Format()
+        fmt.type = _V4L2_BUF_TYPE_VIDEO_OUTPUT
+        pix = fmt.fmt.pix
+        pix.width, pix.height = width, height
+        pix.pixelformat = _V4L2_PIX_FMT_YUYV
+        pix.field = _V4L2_FIELD_NONE
+        pix.bytesperline = width * 2
+        pix.sizeimage = width * height * 2
+        fcntl.ioctl(self._fd, _VIDIOC_S_FMT, fmt)
+        self._yuyv = np.full((height, width * 2), 128, dtype=np.uint8)
+
+    def write(self, gray: np.ndarray) -> float:
+        self._yuyv[:, 0::2] = gray
+        os.write(self._fd, self._yuyv)
+        return time.monotonic()
+
+    def close(self):
+        os.close(self._fd)
+
+
+# ─── Frames ───────────────────────────────────────────────────────────────────
+
+def render_frames(ids, width: int, height: int):
+    """One frame per id: a centered tag36h11 on a light background, with the
+    id printed for eyeballing the stream."""
+    dictionary = cv2.aruco.getPredefinedDictionary(cv2.aruco.DICT_APRILTAG_36h11)
+    side = height // 3
+    frames = {}
+    for tag_id in ids:
+        img = np.full((height, width), 200, dtype=np.uint8)
+        marker = cv2.aruco.generateImageMarker(dictionary, tag_id, side)
+        y0, x0 = (height - side) // 2, (width - side) // 2
+        img[y0:y0 + side, x0:x0 + side] = marker
+        cv2.putText(img, str(tag_id), (20, 60), cv2.FONT_HERSHEY_SIMPLEX, 2.0, 0, 3)
+        frames[tag_id] = img
+    return frames
+
+
+# ─── Probe ────────────────────────────────────────────────────────────────────
+
+class Probe:
+    """Runs the XNavLib probe and collects (tag id, seen time) events."""
+
+    def __init__(self, command: str):
+        self._proc = subprocess.Popen(shlex.split(command), stdout=subprocess.PIPE,
+                                      text=True, bufsize=1)
+        self.ready = threading.Event()
+        self.events = []
+        self._thread = threading.Thread(target=self._read, daemon=True)
+        self._thread.start()
+
+    def _read(self):
+        for line in self._proc.stdout:
+            parts = line.split()
+            if parts == ["ready"]:
+                self.ready.set()
+            elif len(parts) == 2:
+                self.events.append((int(parts[0]), int(parts[1]) / 1e9))
+
+    def stop(self):
+        self._proc.terminate()
+        try:
+            self._proc.wait(timeout=2.0)
+        except subprocess.TimeoutExpired:
+            self._proc.kill()
+        self._thread.join(timeout=1.0)
+
+
+def match_latencies(injected, events, cycle_s: float):
+    """Latency of every injected frame the probe saw, in ms. Ids repeat every
+    cycle, so an event matches the latest injection of its id before it."""
+    last_by_id = {}
+    latencies = []
+    seen = set()
+    i = 0
+    for tag_id, t_seen in sorted(events, key=lambda e: e[1]):
+        while i < len(injected) and injected[i][1] <= t_seen:
+            last_by_id[injected[i][0]] = i
+            i += 1
+        k = last_by_id.get(tag_id)
+        if k is None or k in seen or t_seen - injected[k][1] > cycle_s:
+            continue
+        seen.add(k)
+        latencies.append((t_seen - injected[k][1]) * 1000.0)
+    return latencies
+
+
+def summarize(latencies, injected_count: int) -> dict:
+    out = {"frames": injected_count, "seen": len(latencies),
+           "missed": injected_count - len(latencies)}
+    if latencies:
+        arr = np.array(latencies)
+        out.update({"min_ms": float(arr.min()), "p50_ms": float(np.percentile(arr, 50)),
+                    "p90_ms": float(np.percentile(arr, 90)),
+                    "p99_ms": float(np.percentile(arr, 99)), "max_ms": float(arr.max()),
+                    "mean_ms": float(arr.mean())})
+    return {k: round(v, 2) if isinstance(v, float) else v for k, v in out.items()}
+
+
+# ─── Main ─────────────────────────────────────────────────────────────────────
+
+def main():
+    ap = argparse.ArgumentParser(description="XNav glass-to-robot latency rig")
+    ap.add_argument("--backend", choices=("shm", "v4l2"), default="shm")
+    ap.add_argument("--device", default="/dev/shm/xnav_rig",
+                    help="shm file or v4l2loopback node")
+    ap.add_argument("--width", type=int, default=1280)
+    ap.add_argument("--height", type=int, default=720)
+    ap.add_argument("--fps", type=float, default=60.0)
+    ap.add_argument("--frames", type=int, default=600)
+    ap.add_argument("--ids", type=int, default=30,
+                    help="frame counter cycle (tag ids 0..N-1); N/fps must exceed the latency")
+    ap.add_argument("--warmup", type=float, default=2.0, help="seconds of frames before measuring")
+    ap.add_argument("--probe", help="probe command line, e.g. './xnav_latency_probe 127.0.0.1'")
+    ap.add_argument("--json", action="store_true", help="print the summary as JSON")
+    args = ap.parse_args()
+
+    ids = list(range(max(2, args.ids)))
+    frames = render_frames(ids, args.width, args.height)
+    if args.backend == "shm":
+        writer = FakeFrameWriter(args.device, args.width, args.height)
+    else:
+        writer = LoopbackWriter(args.device, args.width, args.height)
+
+    probe = Probe(args.probe) if args.probe else None
+    period = 1.0 / args.fps
+    injected = []
+    try:
+        # Keep the pipeline fed while the probe connects and XNav settles
+        t_next = time.monotonic()
+        warm_until = t_next + args.warmup
+        k = 0
+        while time.monotonic() < warm_until or (probe and not probe.ready.is_set()):
+            writer.write(frames[ids[k % len(ids)]])
+            k += 1
+            t_next += period
+            time.sleep(max(0.0, t_next - time.monotonic()))
+            if probe and time.monotonic() > warm_until + 10.0 and not probe.ready.is_set():
+                print("Probe did not connect", file=sys.stderr)
+                return 1
+
+        for k in range(args.frames):
+            tag_id = ids[k % len(ids)]
+            injected.append((tag_id, writer.write(frames[tag_id])))
+            t_next += period
+            time.sleep(max(0.0, t_next - time.monotonic()))
+        # Let the last frames drain through the pipeline
+        time.sleep(0.5)
+    finally:
+        if probe:
+            probe.stop()
+        writer.close()
+
+    if probe is None:
+        print(f"Injected {len(injected)} frames (no probe, nothing measured)")
+        return 0
+
+    summary = summarize(match_latencies(injected, probe.events, len(ids) * period),
+                        len(injected))
+    if args.json:
+        print(json.dumps(summary))
+    else:
+        print(f"frames {summary['frames']}  seen {summary['seen']}  missed {summary['missed']}")
+        if summary["seen"]:
+            print("latency ms: min {min_ms}  p50 {p50_ms}  p90 {p90_ms}  p99 {p99_ms}  "
+                  "max {max_ms}  mean {mean_ms}".format(**summary))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
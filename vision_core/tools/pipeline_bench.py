@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""
+XNav Pipeline Benchmark
+
+Runs the per-frame stages of the vision pipeline on synthetic frames (the
+latency rig's tag frames) and reports, per stage and per call, the wall time
+and - when the kernel allows perf_event_open - cycles, instructions, IPC,
+cache misses and branch misses. Counter deltas tell whether a data-layout
+change (detection batches, frame pool, pyramid) actually made the work
+cheaper when wall time on a busy CM4 is too noisy to say.
+
+  python3 pipeline_bench.py --frames 300 --tags 4
+  python3 pipeline_bench.py --json > before.json
+"""
+
+import os
+import sys
+import json
+import argparse
+import tempfile
+import cv2
+import numpy as np
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src"))
+from config_manager import ConfigManager        # noqa: E402
+from frame_pool import FramePool                # noqa: E402
+from motion_gate import MotionGate              # noqa: E402
+from apriltag_detector import AprilTagDetector, DetectionBatch  # noqa: E402
+from pose_calculator import PoseCalculator      # noqa: E402
+from perf_counters import StageProfiler         # noqa: E402
+from latency_rig import render_frames           # noqa: E402
+
+
+def synthetic_batch(n: int) -> DetectionBatch:
+    """n posed detections (for the batch stages when no detector is installed)."""
+    rng = np.random.default_rng(5805)
+    batch = DetectionBatch(n, 0, 0.0)
+    batch.ids[:] = rng.permutation(32)[:n] if n <= 32 else np.arange(n)
+    batch.has_pose[:] = True
+    batch.R[:] = np.eye(3)
+    batch.t[:] = rng.uniform([-1, -0.5, 1], [1, 0.5, 6], size=(n, 3))
+    batch.update_derived()
+    return batch
+
+
+def run(args) -> dict:
+    tmp = tempfile.mkdtemp(prefix="xnav_bench_")
+    cfg = ConfigManager(os.path.join(tmp, "config.json"))
+    cfg.set("low_power", dict(cfg.get("low_power") or {}, enabled=True))
+    cfg.set("offset_point", dict(cfg.get("offset_point") or {}, enabled=True, tag_id=1))
+    if args.prepass:
+        cfg.set("apriltag", dict(cfg.get("apriltag") or {}, prepass=True))
+
+    pool = FramePool(4)
+    gate = MotionGate(cfg)
+    detector = AprilTagDetector(cfg)
+    pose_calc = PoseCalculator(cfg)
+    has_detector = detector.available
+
+    # Color frames cycling through the tag images (converted as capture does)
+    grays = render_frames(list(range(args.tags)), args.width, args.height)
+    bgrs = [cv2.cvtColor(g, cv2.COLOR_GRAY2BGR) for g in grays.values()]
+    fallback = synthetic_batch(args.tags)
+
+    prof = StageProfiler(use_counters=not args.no_counters)
+    for i in range(args.warmup + args.frames):
+        if i == args.warmup:
+            prof.close()
+            prof = StageProfiler(use_counters=not args.no_counters)
+        ts = i / 60.0
+        buf = pool.acquire((args.height, args.width))
+        np.copyto(buf.bgr, bgrs[i % len(bgrs)])
+        with prof.stage("convert"):
+            cv2.cvtColor(buf.bgr, cv2.COLOR_BGR2GRAY, dst=buf.gray)
+        with prof.stage("pyramid"):
+            buf.level(2)
+        with prof.stage("motion_gate"):
+            gate.should_process(buf, ts, False)
+        if args.prepass:
+            with prof.stage("prepass"):
+                detector._run_prepass(buf.gray)
+        if has_detector:
+            with prof.stage("detect"):
+                batch = detector.detect(buf.gray, ts)
+        else:
+            batch = fallback
+        with prof.stage("turret"):
+            pose_calc.apply_turret(batch.select(np.arange(len(batch))), 15.0)
+        with prof.stage("merge"):
+            DetectionBatch.concat([batch, batch]).closest_per_id()
+        with prof.stage("offset_point"):
+            pose_calc.compute_offset_point(batch, cfg.get("offset_point") or {})
+        with prof.stage("publish_pack"):
+            batch.pack()
+            batch.to_dicts()
+        buf.release()
+
+    report = {"frames": args.frames, "size": f"{args.width}x{args.height}",
+              "detector": detector.backend if has_detector else None, "counters": prof.counters_available,
+              "stages": prof.report()}
+    prof.close()
+    return report
+
+
+def main():
+    ap = argparse.ArgumentParser(description="XNav pipeline stage benchmark")
+    ap.add_argument("--frames", type=int, default=300)
+    ap.add_argument("--warmup", type=int, default=20)
+    ap.add_argument("--width", type=int, default=1280)
+    ap.add_argument("--height", type=int, default=720)
+    ap.add_argument("--tags", type=int, default=4, help="distinct tag frames / batch size")
+    ap.add_argument("--no-counters", action="store_true", help="wall time only")
+    ap.add_argument("--prepass", action="store_true",
+                    help="enable the native detector pre-pass (and time it on its own)")
+    ap.add_argument("--json", action="store_true", help="print the report as JSON")
+    args = ap.parse_args()
+
+    report = run(args)
+    if args.json:
+        print(json.dumps(report, indent=2))
+        return 0
+
+    print(f"{report['frames']} frames {report['size']}  detector: "
+          f"{report['detector'] or 'no (synthetic batches)'}  "
+          f"counters: {'yes' if report['counters'] else 'no'}")
+    cols = ("wall_ms", "cycles", "instructions", "ipc", "cache_misses", "branch_misses")
+    print(f"{'stage':<14}" + "".join(f"{c:>15}" for c in cols))
+    for name, row in report["stages"].items():
+        cells = []
+        for c in cols:
+            v = row.get(c)
+            cells.append(f"{'-':>15}" if v is None else
+                         f"{v:>15.3f}" if c in ("wall_ms", "ipc") else f"{v:>15.0f}")
+        print(f"{name:<14}" + "".join(cells))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -95,23 +95,10 @@ def vendor_file(filename):
 
 @app.route("/api/status")
 def api_status():
-    p = _get_pipeline()
-    if p:
-        from main import get_shared_state
-        state = get_shared_state()
-        dets = state.get("detections", [])
-        robot_pose = state.get("robot_pose")
-        offset = state.get("offset_result")
-        return jsonify({
-            "status": state.get("status", "unknown"),
-            "fps": state.get("fps", 0),
-            "latency_ms": state.get("latency_ms", 0),
-            "nt_connected": p.nt.is_connected(),
-            "num_targets": len(dets),
-            "targets": [_tag_to_dict(d) for d in dets],
-            "robot_pose": _robot_pose_to_dict(robot_pose),
-            "offset_result": _offset_to_dict(offset),
-        })
+    # Served from the telemetry publisher's cache - no per-request serialization
+    snap = telemetry.snapshot()
+    if snap is not None:
+        return jsonify(snap)
     return jsonify({"status": "dashboard-only", "fps": 0, "latency_ms": 0,
                     "nt_connected": False, "num_targets": 0, "targets": [],
                     "robot_pose": None, "offset_result": None})
@@ -134,7 +121,8 @@ def api_config_post():
     # Reload pipeline if running
     p = _get_pipeline()
     if p:
-        p.detector.reload_config()
+        for det in p.detectors:
+            det.reload_config()
     return jsonify({"ok": True})
 
 @app.route("/api/config/<section>", methods=["GET"])
@@ -252,7 +240,8 @@ def api_cal_compute():
             if result:
                 p.detector.set_calibration(
                     np.array(result["camera_matrix"]),
-                    np.array(result["dist_coeffs"])
+                    np.array(result["dist_coeffs"]),
+                    result.get("image_size")
                 )
         socketio.emit("calibration_result", {"ok": ok, "message": msg})
 
@@ -285,12 +274,15 @@ def api_cal_result():
 
 @app.route("/stream.mjpg")
 def mjpeg_stream():
+    # ?level=N streams the 1/2**N gray pyramid level instead of full color
+    level = request.args.get("level", 0, type=int)
+
     def gen():
         while True:
             p = _get_pipeline()
             frame_bytes = None
             if p:
-                frame_bytes = p.camera.get_jpeg_frame(quality=60)
+                frame_bytes = p.camera.get_jpeg_frame(quality=60, level=level)
             if frame_bytes is None:
                 time.sleep(0.033)
                 continue
@@ -305,10 +297,12 @@ def calib_stream():
         while True:
             p = _get_pipeline()
             if p:
-                frame, gray, _ = p.camera.get_frame()
+                # Pooled frame by reference; draw_preview renders its own image
+                frame = p.camera.acquire_latest()
                 if frame is not None:
                     import cv2
-                    overlay = p.calibration.draw_preview(frame)
+                    with frame:
+                        overlay = p.calibration.draw_preview(frame)
                     _, buf = cv2.imencode(".jpg", overlay, [cv2.IMWRITE_JPEG_QUALITY, 60])
                     yield (b"--frame\r\nContent-Type: image/jpeg\r\n\r\n" + buf.tobytes() + b"\r\n")
             time.sleep(0.1)
@@ -360,48 +354,103 @@ def api_restart_vision():
 @socketio.on("connect")
 def on_connect():
     emit("connected", {"message": "Connected to XNav dashboard"})
+    # New clients get one full snapshot; afterwards they only receive deltas
+    snap = telemetry.snapshot()
+    if snap is not None:
+        emit("state_update", snap)
+
+
+class TelemetryPublisher:
+    """
+    Single server-side publisher for live dashboard state.
+
+    Each pipeline state change is serialized once, at a capped rate, and only
+    the top-level fields that changed are pushed to all connected clients as
+    'state_delta'. /api/status and newly connected clients read the cached
+    snapshot instead of serializing the shared state again.
+    """
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._snapshot = None
+        self._seq = -1
+
+    def snapshot(self):
+        with self._lock:
+            if self._snapshot is not None:
+                return self._snapshot
+        # Nothing published yet (or loop not running): build once on demand
+        snap = self._build()
+        if snap is not None:
+            with self._lock:
+                self._snapshot = snap
+        return snap
+
+    def run(self):
+        """Background loop: serialize changes and push deltas."""
+        while True:
+            hz = float(get_cfg().get("telemetry_hz") or 10.0)
+            try:
+                self._tick()
+            except Exception as e:
+                logger.debug("Telemetry push error: %s", e)
+            time.sleep(1.0 / max(1.0, hz))
+
+    def _tick(self):
+        p = _get_pipeline()
+        if not p:
+            return
+        from main import get_shared_state_seq
+        seq = get_shared_state_seq()
+        nt_connected = p.nt.is_connected()
+        with self._lock:
+            prev = self._snapshot
+            unchanged = (seq == self._seq and prev is not None
+                         and prev.get("nt_connected") == nt_connected)
+        if unchanged:
+            return
+
+        snap = self._build()
+        if snap is None:
+            return
+        with self._lock:
+            self._snapshot = snap
+            self._seq = seq
+        if prev is None:
+            socketio.emit("state_update", snap)
+            return
+        delta = {k: v for k, v in snap.items() if prev.get(k) != v}
+        if delta:
+            socketio.emit("state_delta", delta)
+
+    @staticmethod
+    def _build():
+        p = _get_pipeline()
+        if not p:
+            return None
+        from main import get_shared_state
+        state = get_shared_state()
+        dets = state["detections"]
+        return {
+            "status": state.get("status", "unknown"),
+            "fps": round(state.get("fps", 0), 1),
+            "latency_ms": round(state.get("latency_ms", 0), 2),
+            "nt_connected": p.nt.is_connected(),
+            "num_targets": len(dets),
+            "targets": dets.to_dicts(),
+            "robot_pose": _robot_pose_to_dict(state.get("robot_pose")),
+            "offset_result": _offset_to_dict(state.get("offset_result")),
+            "temperature_c": state.get("temperature_c", 0.0),
+            "thermal_state": state.get("thermal_state", "unknown"),
+            "throttle_fps": state.get("throttle_fps", 0.0),
+            "low_power": state.get("low_power", False),
+            "calibration": p.calibration.get_status(),
+        }
 
-def _push_state_loop():
-    """Background thread: push status updates to all connected clients."""
-    while True:
-        try:
-            p = _get_pipeline()
-            if p:
-                from main import get_shared_state
-                state = get_shared_state()
-                dets = state.get("detections", [])
-                socketio.emit("state_update", {
-                    "status": state.get("status", "unknown"),
-                    "fps": round(state.get("fps", 0), 1),
-                    "latency_ms": round(state.get("latency_ms", 0), 2),
-                    "nt_connected": p.nt.is_connected(),
-                    "num_targets": len(dets),
-                    "targets": [_tag_to_dict(d) for d in dets],
-                    "robot_pose": _robot_pose_to_dict(state.get("robot_pose")),
-                    "offset_result": _offset_to_dict(state.get("offset_result")),
-                    "temperature_c": state.get("temperature_c", 0.0),
-                    "thermal_state": state.get("thermal_state", "unknown"),
-                    "throttle_fps": state.get("throttle_fps", 0.0),
-                })
-        except Exception:
-            pass
-        time.sleep(0.1)  # 10Hz updates
 
-# ─── Helper serializers ───────────────────────────────────────────────────────
+telemetry = TelemetryPublisher()
 
-def _tag_to_dict(tag) -> dict:
-    return {
-        "id": tag.id,
-        "tx": round(tag.tx, 3),
-        "ty": round(tag.ty, 3),
-        "x": round(tag.x, 4),
-        "y": round(tag.y, 4),
-        "z": round(tag.z, 4),
-        "distance": round(tag.distance, 4),
-        "yaw": round(tag.yaw, 2),
-        "pitch": round(tag.pitch, 2),
-        "roll": round(tag.roll, 2),
-    }
+# ─── Helper serializers ───────────────────────────────────────────────────────
 
 def _robot_pose_to_dict(rp) -> dict:
     if rp is None or not rp.valid:
@@ -433,8 +482,8 @@ def _offset_to_dict(o) -> dict:
 
 def run(host="0.0.0.0", port=5800):
     """Start the web dashboard."""
-    # Start background state push thread
-    threading.Thread(target=_push_state_loop, daemon=True).start()
+    # Start background telemetry push thread
+    threading.Thread(target=telemetry.run, daemon=True, name="telemetry").start()
     port = get_cfg().get("web_port") or port
     logger.info("XNav Dashboard starting on http://0.0.0.0:%d", port)
     socketio.run(app, host=host, port=port, allow_unsafe_werkzeug=True)
@@ -7,9 +7,16 @@
 // ── Socket.IO ────────────────────────────────────────────────────────────────
 const socket = io();
 let _matchMode = false;
+// Last full telemetry state; the server pushes one snapshot, then deltas
+let _liveState = null;
 
 socket.on("connect", () => console.log("WS connected"));
-socket.on("state_update", updateState);
+socket.on("state_update", data => { _liveState = data; updateState(_liveState); });
+socket.on("state_delta", delta => {
+  if (!_liveState) return;  // wait for the snapshot sent on connect
+  Object.assign(_liveState, delta);
+  updateState(_liveState);
+});
 socket.on("calibration_result", onCalibrationResult);
 
 // ── Tab navigation ────────────────────────────────────────────────────────────
@@ -39,6 +46,8 @@ function onTabActivated(tab) {
 
 // ── State update ─────────────────────────────────────────────────────────────
 function updateState(data) {
+  if (data.calibration) renderCalibrationStatus(data.calibration);
+
   // Top bar
   setStatus(data.status);
   document.getElementById("badge-fps").textContent = data.fps + " FPS";
@@ -219,7 +228,11 @@ function loadLights() {
     document.getElementById("lights-mode").value = d.mode || "on";
     document.getElementById("lights-brightness").value = d.brightness ?? 100;
     document.getElementById("lights-bright-val").textContent = d.brightness ?? 100;
-    document.getElementById("lights-gpio").value = d.gpio_pin ?? 18;
+    document.getElementById("lights-active-backend").textContent = d.backend ? `(active: ${d.backend})` : "";
+  });
+  fetch("/api/config/lights").then(r => r.json()).then(c => {
+    document.getElementById("lights-gpio").value = c.gpio_pin ?? 18;
+    document.getElementById("lights-backend").value = c.backend || "auto";
   });
 }
 
@@ -233,11 +246,15 @@ function setLights() {
 }
 
 function saveLightsGpio() {
-  const pin = parseInt(document.getElementById("lights-gpio").value);
-  fetch("/api/config/lights", {
-    method:"POST", headers:{"Content-Type":"application/json"},
-    body: JSON.stringify({gpio_pin: pin})
-  }).then(() => showToast("GPIO pin saved. Reboot to apply.", "info"));
+  // The section is replaced as a whole: merge into the current one
+  fetch("/api/config/lights").then(r => r.json()).then(cfg => {
+    cfg.gpio_pin = parseInt(document.getElementById("lights-gpio").value);
+    cfg.backend = document.getElementById("lights-backend").value;
+    return fetch("/api/config/lights", {
+      method:"POST", headers:{"Content-Type":"application/json"},
+      body: JSON.stringify(cfg)
+    });
+  }).then(() => showToast("Output settings saved. Reboot to apply.", "info"));
 }
 
 // ── Field Map ─────────────────────────────────────────────────────────────────
@@ -331,21 +348,17 @@ function loadMount() {
 }
 
 // ── Calibration ───────────────────────────────────────────────────────────────
-let _calPollTimer = null;
-
+// Live progress arrives with the pushed telemetry; fetch once on tab open
 function startCalibrationPoll() {
-  if (_calPollTimer) return;
-  _calPollTimer = setInterval(pollCalibrationStatus, 500);
+  fetch("/api/calibration/status").then(r => r.json()).then(renderCalibrationStatus);
 }
 
-function pollCalibrationStatus() {
-  fetch("/api/calibration/status").then(r => r.json()).then(d => {
-    const pct = d.target > 0 ? Math.round(d.progress / d.target * 100) : 0;
-    document.getElementById("cal-progress-bar").style.width = pct + "%";
-    document.getElementById("cal-progress-text").textContent = d.progress + "/" + d.target;
-    document.getElementById("cal-status-text").textContent = d.status;
-    document.getElementById("btn-compute-cal").disabled = !(d.progress >= 5);
-  });
+function renderCalibrationStatus(d) {
+  const pct = d.target > 0 ? Math.round(d.progress / d.target * 100) : 0;
+  document.getElementById("cal-progress-bar").style.width = pct + "%";
+  document.getElementById("cal-progress-text").textContent = d.progress + "/" + d.target;
+  document.getElementById("cal-status-text").textContent = d.status;
+  document.getElementById("btn-compute-cal").disabled = !(d.progress >= 5);
 }
 
 function startCalibration() {
@@ -443,7 +456,9 @@ function showToast(msg, type = "success") {
 // ── Initial load ──────────────────────────────────────────────────────────────
 window.addEventListener("DOMContentLoaded", () => {
   // Load initial status
-  fetch("/api/status").then(r => r.json()).then(updateState).catch(() => {});
+  fetch("/api/status").then(r => r.json()).then(d => {
+    if (!_liveState) { _liveState = d; updateState(d); }
+  }).catch(() => {});
   // Load match mode state
   fetch("/api/config").then(r => r.json()).then(cfg => {
     _matchMode = !!cfg.match_mode;